@@ -1,13 +1,21 @@
 #pragma GCC optimize("Ofast,no-stack-protector,fast-math")
 #include <vector>
+#include <algorithm>
 #include <limits>
 #include <omp.h>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 
 template <typename T, std::size_t Alignment>
 struct AlignedAllocator {
@@ -49,25 +57,26 @@ inline bool operator!=(const AlignedAllocator<T, Alignment>& a,
     return !(a == b);
 }
 
-using AlignedUInt8Buffer = std::vector<uint8_t, AlignedAllocator<uint8_t, 32>>;
-
 namespace py = pybind11;
 
-// ---------- 工具：比较两个 char 网格是否完全一致 ----------
-static inline bool equal_grid_char(const std::vector<std::vector<char>>& A,
-                                   const std::vector<std::vector<char>>& B) {
-    if (A.size() != B.size()) return false;
-    for (size_t i = 0; i < A.size(); ++i) {
-        if (A[i].size() != B[i].size()) return false;
-        const char* pa = A[i].data();
-        const char* pb = B[i].data();
-        for (size_t j = 0; j < A[i].size(); ++j) {
-            if (pa[j] != pb[j]) return false;
-        }
-    }
-    return true;
-}
+// ---------- 输入输出：按行存放的 0/1 字节 ----------
+
+/** Read-only row-major grid, non-zero = alive; a flattened list or a NumPy buffer */
+struct CellView {
+    const uint8_t* data = nullptr;
+    int h = 0, w = 0;
+    ptrdiff_t stride = 0;   // 行距（字节）
+
+    const uint8_t* row(int y) const { return data + y * stride; }
+};
 
+/** Bounding box of the live cells in engine coordinates; h = w = 0 when empty */
+struct Extent {
+    int64_t y0 = 0, x0 = 0;
+    int64_t h = 0, w = 0;
+};
+
+// ---------- 字节引擎：每个细胞一个 uint8_t（0/1） ----------
 #if defined(__GNUC__)
 typedef unsigned char u8x16 __attribute__((vector_size(16), may_alias));
 #else
@@ -81,236 +90,1172 @@ static inline void store_u8x16(uint8_t* ptr, u8x16 v) {
     __builtin_memcpy(ptr, &v, 16);
 }
 
-static std::vector<std::vector<char>>
-next_generation_char(const std::vector<std::vector<char>>& grid) {
-    const int h = static_cast<int>(grid.size());
-    const int w = (h > 0) ? static_cast<int>(grid[0].size()) : 0;
-    if (h == 0 || w == 0) return {};
+/**
+ * Next generation of cells [x0, x1) of one row, one byte per cell
+ *
+ * up / mid / dn are the rows above, at and below; cells x0 - 1 and x1 are
+ * read as neighbours, so they must exist.
+ *
+ * @return non-zero iff a cell changed
+ */
+static uint64_t life_row_char(const uint8_t* __restrict up, const uint8_t* __restrict mid,
+                              const uint8_t* __restrict dn, uint8_t* __restrict out, int x0, int x1) {
+    const u8x16 VZERO = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+    const u8x16 VONE  = {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
+    const u8x16 V2    = {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2};
+    const u8x16 V3    = {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3};
+
+    int x = x0;
+    u8x16 changed_v = VZERO;
+
+    // —— SIMD：一次处理 16 列（可访问 x-1/x/x+1）——
+    for (; x + 16 <= x1; x += 16) {
+        // 8 邻居求和（0..8）
+        u8x16 sum = load_u8x16(up + x - 1) + load_u8x16(up + x);
+        sum = sum + load_u8x16(up + x + 1);
+        sum = sum + load_u8x16(mid + x - 1);
+        sum = sum + load_u8x16(mid + x + 1);
+        sum = sum + load_u8x16(dn + x - 1);
+        sum = sum + load_u8x16(dn + x);
+        sum = sum + load_u8x16(dn + x + 1);
+
+        // 当前细胞（0/1）
+        const u8x16 alive = load_u8x16(mid + x);
+
+        // 规则：s==3 || (s==2 && alive==1)
+        u8x16 eq3 = (sum == V3);                 // 0xFF / 0x00
+        u8x16 eq2 = (sum == V2);                 // 0xFF / 0x00
+        u8x16 alive_mask = (alive == VONE);      // 0xFF / 0x00
+        u8x16 mask = eq3 | (eq2 & alive_mask);
+
+        // 压成 1/0
+        u8x16 nextv = mask & VONE;
+        store_u8x16(out + x, nextv);
+        changed_v |= nextv ^ alive;
+    }
+
+    uint64_t lanes[2];
+    __builtin_memcpy(lanes, &changed_v, 16);
+    uint64_t changed = lanes[0] | lanes[1];
+
+    // —— 标量：尾数 ——
+    for (; x < x1; ++x) {
+        const int s = up[x - 1] + up[x] + up[x + 1] + mid[x - 1] + mid[x + 1] + dn[x - 1] + dn[x] + dn[x + 1];
+        const uint8_t nxt = (s == 3 || (s == 2 && mid[x] == 1)) ? 1u : 0u;
+        out[x] = nxt;
+        changed |= nxt ^ mid[x];
+    }
+    return changed;
+}
+
+// ---------- 位压缩引擎：每个 uint64_t 存一行中连续 64 个细胞 ----------
+typedef uint64_t u64x4 __attribute__((vector_size(32), may_alias));
+
+// 向量参数的函数必须内联进调用者：AVX2 克隆与默认版本传递 32 字节向量的 ABI 不同
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define LIFE_INLINE inline __attribute__((always_inline))
+
+static LIFE_INLINE u64x4 load_u64x4(const uint64_t* ptr) {
+    u64x4 v; __builtin_memcpy(&v, ptr, 32); return v;
+}
+static LIFE_INLINE void store_u64x4(uint64_t* ptr, u64x4 v) {
+    __builtin_memcpy(ptr, &v, 32);
+}
+
+/**
+ * B3/S23 for a word of cells with bit-sliced adders
+ *
+ * Each argument holds one neighbourhood position of every cell (nw = the
+ * north-west neighbours, c = the cells themselves). The rows are summed
+ * horizontally into 2-bit counts including the centre, then the three rows
+ * are added; a cell lives next generation iff the 3x3 sum is 3, or 4 and
+ * the cell is alive. Works on uint64_t and on u64x4 alike.
+ */
+template <typename V>
+static LIFE_INLINE V life_word(V nw, V n, V ne, V w, V c, V e, V sw, V s, V se) {
+    // 每行三格之和 (ones, twos)，中间行包含细胞本身
+    const V a1 = nw ^ n ^ ne, a2 = (nw & n) | (ne & (nw ^ n));
+    const V b1 = w ^ c ^ e,   b2 = (w & c) | (e & (w ^ c));
+    const V c1 = sw ^ s ^ se, c2 = (sw & s) | (se & (sw ^ s));
+
+    // 九格和 = s1 + 2 * (a2 + b2 + c2 + k1)
+    const V s1 = a1 ^ b1 ^ c1, k1 = (a1 & b1) | (c1 & (a1 ^ b1));
+    const V x = a2 ^ b2, y = a2 & b2, z = c2 ^ k1, q = c2 & k1;
+    const V odd = x ^ z;
+    const V twos_is_1 = odd & ~(y | q);
+    const V twos_is_2 = ~odd & ((x & z) | (y ^ q));
+
+    // 和为 3：出生或存活；和为 4：活细胞存活
+    return (s1 & twos_is_1) | (~s1 & twos_is_2 & c);
+}
+
+// x86 上额外生成 AVX2 版本，运行时按 CPU 选择；其他平台（如 aarch64）u64x4 拆成 NEON/SSE 寄存器
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define LIFE_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define LIFE_TARGET_CLONES
+#endif
+
+/**
+ * Next generation of words [x0, x1) of one row
+ *
+ * up / mid / dn are the rows above, at and below; words x0 - 1 and x1 are
+ * read for the carry bits at the word edges, so they must exist.
+ *
+ * @return OR of (next ^ current) over the words, non-zero iff a cell changed
+ */
+LIFE_TARGET_CLONES
+static uint64_t life_row_bits(const uint64_t* __restrict up, const uint64_t* __restrict mid,
+                              const uint64_t* __restrict dn, uint64_t* __restrict out, int x0, int x1) {
+    uint64_t changed = 0;
+    int x = x0;
+
+    // 一次 4 个字（256 个细胞）；x-1 / x+1 的非对齐加载提供跨字的进位
+    u64x4 changed_v = {0, 0, 0, 0};
+    for (; x + 4 <= x1; x += 4) {
+        const u64x4 n = load_u64x4(up + x),  nl = load_u64x4(up + x - 1),  nr = load_u64x4(up + x + 1);
+        const u64x4 c = load_u64x4(mid + x), cl = load_u64x4(mid + x - 1), cr = load_u64x4(mid + x + 1);
+        const u64x4 s = load_u64x4(dn + x),  sl = load_u64x4(dn + x - 1),  sr = load_u64x4(dn + x + 1);
+        // 第 b 位是第 b 列：西邻左移一位，东邻右移一位
+        const u64x4 next = life_word<u64x4>((n << 1) | (nl >> 63), n, (n >> 1) | (nr << 63),
+                                            (c << 1) | (cl >> 63), c, (c >> 1) | (cr << 63),
+                                            (s << 1) | (sl >> 63), s, (s >> 1) | (sr << 63));
+        store_u64x4(out + x, next);
+        changed_v |= next ^ c;
+    }
+    changed |= changed_v[0] | changed_v[1] | changed_v[2] | changed_v[3];
+
+    for (; x < x1; ++x) {
+        const uint64_t n = up[x], c = mid[x], s = dn[x];
+        const uint64_t next = life_word<uint64_t>((n << 1) | (up[x - 1] >> 63), n, (n >> 1) | (up[x + 1] << 63),
+                                                  (c << 1) | (mid[x - 1] >> 63), c, (c >> 1) | (mid[x + 1] << 63),
+                                                  (s << 1) | (dn[x - 1] >> 63), s, (s >> 1) | (dn[x + 1] << 63));
+        out[x] = next;
+        changed |= next ^ c;
+    }
+    return changed;
+}
+
+// ---------- 无界画布：两块预分配的缓冲区逐代交换 ----------
+
+/** Cell layout of LifeCanvas: one cell per byte */
+struct ByteCells {
+    using Word = uint8_t;
+    static constexpr int CELLS = 1;       // 每个字的细胞数
+    static constexpr int PAD = 64;        // 扩容时左右至少留出的字数
+
+    static uint64_t step_row(const Word* up, const Word* mid, const Word* dn, Word* out, int x0, int x1) {
+        return life_row_char(up, mid, dn, out, x0, x1);
+    }
+    static int first_cell(Word) { return 0; }
+    static int last_cell(Word) { return 0; }
+};
+
+/** Cell layout of LifeCanvas: 64 cells per word, bit b = column b */
+struct BitCells {
+    using Word = uint64_t;
+    static constexpr int CELLS = 64;
+    static constexpr int PAD = 4;
 
-    // 1) pad 一圈 0
-    const int H = h + 2, W = w + 2;
-    const int stride = ((W + 31) / 32) * 32;
-    AlignedUInt8Buffer padded(H * stride, 0);
-    AlignedUInt8Buffer next_padded(H * stride, 0);
+    static uint64_t step_row(const Word* up, const Word* mid, const Word* dn, Word* out, int x0, int x1) {
+        return life_row_bits(up, mid, dn, out, x0, x1);
+    }
+    static int first_cell(Word w) { return __builtin_ctzll(w); }
+    static int last_cell(Word w) { return 63 - __builtin_clzll(w); }
+};
+
+/**
+ * Unbounded Life on a flat canvas that persists across generations
+ *
+ * Two preallocated buffers hold the current and the next generation and are
+ * swapped after each step; nothing is allocated or copied per generation.
+ * The canvas keeps a margin of empty rows / words around the live cells and
+ * is reallocated (recentred, with fresh margin) only when the pattern gets
+ * close to its edge. Each step computes the bounding box of the live cells
+ * plus one row / word on every side, and reports whether any cell changed
+ * instead of comparing whole grids.
+ *
+ * step_block(t) advances t generations per pass over memory (temporal
+ * blocking): the region is cut into row bands, and each band plus a halo of
+ * t rows on both sides is copied into a scratch buffer sized for L2 and
+ * advanced t generations there, the valid rows shrinking by one per
+ * generation (overlapped trapezoids). Bands are independent and run in
+ * parallel; the halo rows are computed redundantly.
+ *
+ * @tparam Cells  ByteCells or BitCells
+ */
+template <class Cells>
+class LifeCanvas {
+public:
+    using Word = typename Cells::Word;
+
+    explicit LifeCanvas(const CellView& grid);
+
+    /** Advance one generation; false once the pattern is empty or stopped changing */
+    bool step();
+
+    /**
+     * Advance t generations in one pass over memory; false once the pattern
+     * is empty or did not change in the last of them
+     *
+     * When two scratch bands of at least 4t rows do not fit BLOCK_BYTES the
+     * generations are split into shorter passes (t = 1 on very wide rows).
+     */
+    bool step_block(int t);
+
+    /** Upper bound of t accepted by simulate() */
+    static constexpr int MAX_TIME_BLOCK = 64;
+
+    /** Bounding box of the live cells */
+    Extent extent() const;
 
+    /** Write the cells of box (from extent()) as 0/1 bytes, box.h x box.w row-major */
+    void write(const Extent& box, uint8_t* out) const;
+
+private:
+    using Buffer = std::vector<Word, AlignedAllocator<Word, 32>>;
+
+    static constexpr int MARGIN = 2;          // 计算区外再读一行/一字，再留一圈保证为 0
+    static constexpr int PAD_Y = 64;          // 扩容时上下至少留出的行数
+    static constexpr size_t BLOCK_BYTES = size_t(256) << 10;   // step_block 每线程两份草稿的总大小
+    static constexpr int THREADS = 4;         // 访存密集，4 个线程已足够
+
+    void alloc(int rows, int words, int src_y, int src_x);
+    void ensure_margin(int margin_y, int margin_x);
+    void finish_step(int ny0, int ny1, int nx0, int nx1);
+    Word* row(Buffer& buf, int y) { return buf.data() + size_t(y) * words_; }
+    const Word* row(const Buffer& buf, int y) const { return buf.data() + size_t(y) * words_; }
+
+    int rows_ = 0, words_ = 0;
+    Buffer cur_, next_;
+    int y0_ = 0, y1_ = -1, x0_ = 0, x1_ = -1;    // cur_ 中活细胞的包围盒（行、字，闭区间）
+    int dy0_ = 0, dy1_ = -1, dx0_ = 0, dx1_ = -1; // next_ 中可能残留旧细胞的区域
+    Buffer scratch_[THREADS][2];              // step_block 每线程的两份草稿，只增不减，跨趟复用
+};
+
+template <class Cells>
+LifeCanvas<Cells>::LifeCanvas(const CellView& grid) {
+    constexpr int C = Cells::CELLS;
+    const int h = grid.h, w = grid.w;
+    rows_ = h + 2 * PAD_Y;
+    words_ = (w + C - 1) / C + 2 * Cells::PAD;
+    cur_.assign(size_t(rows_) * words_, 0);
+    next_.assign(size_t(rows_) * words_, 0);
+
+    // 字节 -> 画布（更小带宽，提升 cache locality）
     for (int y = 0; y < h; ++y) {
-        uint8_t* row = padded.data() + (y + 1) * stride;
-        std::memcpy(row + 1, grid[y].data(), size_t(w));
+        Word* dst = row(cur_, y + PAD_Y) + Cells::PAD;
+        const uint8_t* src = grid.row(y);
+        for (int x = 0; x < w; ++x) {
+            if (!src[x]) continue;
+            dst[x / C] |= Word(1) << (x % C);
+            const int wx = Cells::PAD + x / C;
+            y0_ = (y1_ < 0) ? y + PAD_Y : y0_;
+            x0_ = (y1_ < 0) ? wx : std::min(x0_, wx);
+            x1_ = std::max(x1_, wx);
+            y1_ = y + PAD_Y;
+        }
     }
+}
 
-    // 2) 并行计算：沿 y 分成 16 个块，每个线程处理一段连续行
+template <class Cells>
+void LifeCanvas<Cells>::alloc(int rows, int words, int src_y, int src_x) {
+    // 只搬包围盒；新画布上活细胞从 (src_y, src_x) 开始
+    Buffer fresh(size_t(rows) * words, 0);
+    for (int y = y0_; y <= y1_; ++y) {
+        std::memcpy(fresh.data() + size_t(src_y + y - y0_) * words + src_x,
+                    row(cur_, y) + x0_, size_t(x1_ - x0_ + 1) * sizeof(Word));
+    }
+    cur_.swap(fresh);
+    next_.assign(size_t(rows) * words, 0);
+    y1_ = src_y + (y1_ - y0_);
+    y0_ = src_y;
+    x1_ = src_x + (x1_ - x0_);
+    x0_ = src_x;
+    rows_ = rows;
+    words_ = words;
+    dy1_ = dx1_ = -1;
+}
 
-    int g_min_y = std::numeric_limits<int>::max();
-    int g_min_x = std::numeric_limits<int>::max();
-    int g_max_y = -1;
-    int g_max_x = -1;
+template <class Cells>
+void LifeCanvas<Cells>::ensure_margin(int margin_y, int margin_x) {
+    // 包围盒离边缘不足 margin + 1 时扩容：四周各留出与图案等大的空白
+    if (y0_ <= margin_y || y1_ >= rows_ - 1 - margin_y || x0_ <= margin_x || x1_ >= words_ - 1 - margin_x) {
+        const int bh = y1_ - y0_ + 1, bw = x1_ - x0_ + 1;
+        const int pad_y = std::max({PAD_Y, bh, 2 * margin_y}), pad_x = std::max({Cells::PAD, bw, 2 * margin_x});
+        alloc(bh + 2 * pad_y, bw + 2 * pad_x, pad_y, pad_x);
+    }
+}
 
-    const u8x16 VZERO = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-    const u8x16 VONE  = {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
-    const u8x16 V2    = {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2};
-    const u8x16 V3    = {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3};
+template <class Cells>
+void LifeCanvas<Cells>::finish_step(int ny0, int ny1, int nx0, int nx1) {
+    // 旧的 cur_ 变成下一代的 next_，它的活细胞只在旧包围盒内
+    cur_.swap(next_);
+    dy0_ = y0_; dy1_ = y1_; dx0_ = x0_; dx1_ = x1_;
+    y0_ = ny0; y1_ = ny1; x0_ = nx0; x1_ = nx1;
+}
 
-    auto L  = [](const uint8_t* p, int off) -> u8x16 { return load_u8x16(p + off); };
-    auto LZ = [&](const uint8_t* p, int off) -> u8x16 { return p ? load_u8x16(p + off) : VZERO; };
-
-    const int NT = 4;                                         // 线程数/分块数
-    const int CH = (H + NT - 1) / NT;                          // 每块行数（最后一块可能较短）
-
-    #pragma omp parallel for num_threads(NT) schedule(static,1) if(H*W >= 8192)
-    for (int t = 0; t < NT; ++t) {
-        const int y0 = t * CH;
-        const int y1 = std::min(H, y0 + CH);
-        if (y0 >= y1) continue;
-
-        int local_min_y = std::numeric_limits<int>::max();
-        int local_min_x = std::numeric_limits<int>::max();
-        int local_max_y = -1;
-        int local_max_x = -1;
-
-        for (int y = y0; y < y1; ++y) {
-            const uint8_t* prow_m1 = (y > 0)     ? padded.data() + (y - 1) * stride : nullptr;
-            const uint8_t* prow    =               padded.data() +  y      * stride;
-            const uint8_t* prow_p1 = (y + 1 < H) ? padded.data() + (y + 1) * stride : nullptr;
-            uint8_t*       outrow  =               next_padded.data() +  y  * stride;
-
-            // —— 标量：左边缘（避免 x-1 越界）——
-            int x = 0;
-            for (; x < 1 && x < W; ++x) {
-                int s = 0;
-                if (prow_m1) {
-                    if (x > 0)      s += (int)prow_m1[x - 1];
-                    s += (int)prow_m1[x];
-                    if (x + 1 < W) s += (int)prow_m1[x + 1];
-                }
-                if (x > 0)      s += (int)prow[x - 1];
-                if (x + 1 < W) s += (int)prow[x + 1];
-                if (prow_p1) {
-                    if (x > 0)      s += (int)prow_p1[x - 1];
-                    s += (int)prow_p1[x];
-                    if (x + 1 < W) s += (int)prow_p1[x + 1];
-                }
-                const int alive = (int)prow[x];
-                const uint8_t nxt = (s == 3 || (s == 2 && alive == 1)) ? 1u : 0u;
-                outrow[x] = nxt;
-
-                if (nxt) {
-                    if (y < local_min_y) local_min_y = y;
-                    if (x < local_min_x) local_min_x = x;
-                    if (y > local_max_y) local_max_y = y;
-                    if (x > local_max_x) local_max_x = x;
-                }
+template <class Cells>
+bool LifeCanvas<Cells>::step() {
+    if (y1_ < 0) return false;
+    ensure_margin(MARGIN, MARGIN);
+
+    // 计算区：包围盒外扩一行/一字，并覆盖 next_ 里上上代留下的区域
+    int cy0 = y0_ - 1, cy1 = y1_ + 1, cx0 = x0_ - 1, cx1 = x1_ + 1;
+    if (dy1_ >= 0) {
+        cy0 = std::min(cy0, dy0_); cy1 = std::max(cy1, dy1_);
+        cx0 = std::min(cx0, dx0_); cx1 = std::max(cx1, dx1_);
+    }
+
+    int ny0 = std::numeric_limits<int>::max(), ny1 = -1;
+    int nx0 = std::numeric_limits<int>::max(), nx1 = -1;
+    uint64_t changed = 0;
+    const size_t work = size_t(cy1 - cy0 + 1) * (cx1 - cx0 + 1);
+
+    // 访存密集，4 个线程已足够；区域小时不开并行
+    #pragma omp parallel for num_threads(4) schedule(static) if(work >= 8192) \
+        reduction(min:ny0, nx0) reduction(max:ny1, nx1) reduction(|:changed)
+    for (int y = cy0; y <= cy1; ++y) {
+        Word* out = row(next_, y);
+        changed |= Cells::step_row(row(cur_, y - 1), row(cur_, y), row(cur_, y + 1), out, cx0, cx1 + 1);
+        int lo = cx0, hi = cx1;
+        while (lo <= hi && out[lo] == 0) ++lo;
+        while (hi >= lo && out[hi] == 0) --hi;
+        if (lo <= hi) {
+            ny0 = std::min(ny0, y); ny1 = std::max(ny1, y);
+            nx0 = std::min(nx0, lo); nx1 = std::max(nx1, hi);
+        }
+    }
+
+    finish_step(ny0, ny1, nx0, nx1);
+    return changed != 0 && y1_ >= 0;
+}
+
+template <class Cells>
+bool LifeCanvas<Cells>::step_block(int t) {
+    if (t <= 1) return step();
+    if (y1_ < 0) return false;
+
+    // 两份草稿（带高 >= 2t，再加上下各 t 行）须放进 BLOCK_BYTES；放不下就缩短 t，分几趟推进
+    constexpr int C = Cells::CELLS;
+    const int bw = x1_ - x0_ + 1;
+    // 计算区比包围盒高出 2t 行；矮图案（如滑翔机）的晕圈开销大于省下的访存，t 不超过高度的 1/4
+    int t_fit = std::min(t, std::max(1, (y1_ - y0_ + 1) / 4));
+    while (t_fit > 1 && size_t(8) * t_fit * (bw + 2 * ((t_fit + C - 1) / C) + 2) * sizeof(Word) > BLOCK_BYTES) {
+        --t_fit;
+    }
+    if (t_fit < t) {
+        for (; t > t_fit; t -= t_fit) {
+            if (!step_block(t_fit)) return false;
+        }
+        return step_block(t);
+    }
+
+    // t 代内细胞最多外扩 t 行 / gx 字
+    const int gx = (t + Cells::CELLS - 1) / Cells::CELLS;
+    ensure_margin(t + MARGIN, gx + MARGIN);
+
+    int cy0 = y0_ - t, cy1 = y1_ + t, cx0 = x0_ - gx, cx1 = x1_ + gx;
+    if (dy1_ >= 0) {
+        cy0 = std::min(cy0, dy0_); cy1 = std::max(cy1, dy1_);
+        cx0 = std::min(cx0, dx0_); cx1 = std::max(cx1, dx1_);
+    }
+
+    // 草稿行含字 cx0-1 .. cx1+1，两端那一字始终为 0
+    const int cw = cx1 - cx0 + 1, sw = cw + 2;
+    const int n_rows = cy1 - cy0 + 1;
+    const int band = std::min(n_rows, std::max(2 * t, int(BLOCK_BYTES / (2 * sizeof(Word) * sw)) - 2 * t));
+    const int n_bands = (n_rows + band - 1) / band;
+
+    int ny0 = std::numeric_limits<int>::max(), ny1 = -1;
+    int nx0 = std::numeric_limits<int>::max(), nx1 = -1;
+    uint64_t changed = 0;
+
+    const size_t s_size = size_t(band + 2 * t) * sw;
+    #pragma omp parallel num_threads(THREADS) if(size_t(n_rows) * cw >= 8192) \
+        reduction(min:ny0, nx0) reduction(max:ny1, nx1) reduction(|:changed)
+    {
+        Buffer& a = scratch_[omp_get_thread_num()][0];
+        Buffer& b = scratch_[omp_get_thread_num()][1];
+        if (a.size() < s_size) a.resize(s_size);
+        if (b.size() < s_size) b.resize(s_size);
+
+        #pragma omp for schedule(static)
+        for (int bi = 0; bi < n_bands; ++bi) {
+            const int b0 = cy0 + bi * band, b1 = std::min(cy1, b0 + band - 1);
+            const int s_rows = b1 - b0 + 1 + 2 * t;
+
+            // 装入带及上下各 t 行；包围盒外的行都是 0，不必读画布
+            for (int sr = 0; sr < s_rows; ++sr) {
+                const int y = b0 - t + sr;
+                Word* dst = a.data() + size_t(sr) * sw;
+                if (y >= y0_ && y <= y1_) std::memcpy(dst, row(cur_, y) + cx0 - 1, sizeof(Word) * sw);
+                else std::memset(dst, 0, sizeof(Word) * sw);
+                b[size_t(sr) * sw] = b[size_t(sr) * sw + sw - 1] = 0;
             }
 
-            // —— SIMD：一次处理 16 列（可访问 x-1/x/x+1）——
-            int vec_start = std::max(x, 1);                     // 至少从 x=1 开始
-            int vec_end   = (W >= 1) ? W - 1 : 0;               // 留出最后一列给标量
-            if (vec_end < vec_start) vec_end = vec_start;
-            int vec_limit = vec_start + ((vec_end - vec_start) & ~15); // 对齐到 16 倍数
-
-            for (x = vec_start; x + 15 < vec_limit; x += 16) {
-                // 上一行
-                u8x16 tL = LZ(prow_m1, x - 1);
-                u8x16 tC = LZ(prow_m1, x    );
-                u8x16 tR = LZ(prow_m1, x + 1);
-                // 本行（左右）
-                u8x16 mL = L (prow,    x - 1);
-
-                // 当前细胞（0/1）
-                u8x16 alive = L(prow, x);
-
-                u8x16 mR = L (prow,    x + 1);
-                // 下一行
-                u8x16 bL = LZ(prow_p1, x - 1);
-                u8x16 bC = LZ(prow_p1, x    );
-                u8x16 bR = LZ(prow_p1, x + 1);
-
-                // 8 邻居求和（0..8）
-                u8x16 sum = tL + tC;
-                sum = sum + tR;
-                sum = sum + mL;
-                sum = sum + mR;
-                sum = sum + bL;
-                sum = sum + bC;
-                sum = sum + bR;
-
-                
-
-                // 规则：s==3 || (s==2 && alive==1)
-                u8x16 eq3 = (sum == V3);                 // 0xFF / 0x00
-                u8x16 eq2 = (sum == V2);                 // 0xFF / 0x00
-                u8x16 alive_mask = (alive == VONE);      // 0xFF / 0x00
-                u8x16 mask = eq3 | (eq2 & alive_mask);
-
-                // 压成 1/0
-                u8x16 nextv = mask & VONE;
-                store_u8x16(outrow + x, nextv);
-
-                // 粗 bbox：只要该 16 列块有非零
-                uint64_t lanes[2];
-                __builtin_memcpy(lanes, &nextv, 16);
-                if ((lanes[0] | lanes[1]) != 0ull) {
-                    if (y < local_min_y) local_min_y = y;
-                    if (x < local_min_x) local_min_x = x;
-                    if (y > local_max_y) local_max_y = y;
-                    if (x + 15 > local_max_x) local_max_x = x + 15;
+            // 第 g 代可信的行是 [g, s_rows - g)，最后一代恰好是带本身
+            Word* src = a.data();
+            Word* dst = b.data();
+            uint64_t last_changed = 0;
+            for (int g = 1; g <= t; ++g) {
+                for (int sr = g; sr < s_rows - g; ++sr) {
+                    const uint64_t ch = Cells::step_row(src + size_t(sr - 1) * sw, src + size_t(sr) * sw,
+                                                        src + size_t(sr + 1) * sw, dst + size_t(sr) * sw, 1, cw + 1);
+                    if (g == t) last_changed |= ch;
                 }
+                std::swap(src, dst);
             }
+            changed |= last_changed;
 
-            // —— 标量：尾数 + 右边缘 —— 
-            for (; x < W; ++x) {
-                int s = 0;
-                if (prow_m1) {
-                    if (x > 0)      s += (int)prow_m1[x - 1];
-                    s += (int)prow_m1[x];
-                    if (x + 1 < W) s += (int)prow_m1[x + 1];
+            for (int y = b0; y <= b1; ++y) {
+                Word* out = row(next_, y) + cx0;
+                std::memcpy(out, src + size_t(y - b0 + t) * sw + 1, sizeof(Word) * cw);
+                int lo = 0, hi = cw - 1;
+                while (lo <= hi && out[lo] == 0) ++lo;
+                while (hi >= lo && out[hi] == 0) --hi;
+                if (lo <= hi) {
+                    ny0 = std::min(ny0, y); ny1 = std::max(ny1, y);
+                    nx0 = std::min(nx0, cx0 + lo); nx1 = std::max(nx1, cx0 + hi);
                 }
-                if (x > 0)      s += (int)prow[x - 1];
-                if (x + 1 < W) s += (int)prow[x + 1];
-                if (prow_p1) {
-                    if (x > 0)      s += (int)prow_p1[x - 1];
-                    s += (int)prow_p1[x];
-                    if (x + 1 < W) s += (int)prow_p1[x + 1];
+            }
+        }
+    }
+
+    finish_step(ny0, ny1, nx0, nx1);
+    return changed != 0 && y1_ >= 0;
+}
+
+template <class Cells>
+Extent LifeCanvas<Cells>::extent() const {
+    if (y1_ < 0) return {};
+    constexpr int C = Cells::CELLS;
+
+    // 包围盒精确到细胞：位压缩时字内用 ctz / clz 找最左、最右的列
+    int min_x = std::numeric_limits<int>::max(), max_x = -1;
+    for (int y = y0_; y <= y1_; ++y) {
+        const Word* r = row(cur_, y);
+        for (int x = x0_; x <= x1_; ++x) {
+            if (r[x] == 0) continue;
+            min_x = std::min(min_x, x * C + Cells::first_cell(r[x]));
+            max_x = std::max(max_x, x * C + Cells::last_cell(r[x]));
+        }
+    }
+    return {y0_, min_x, y1_ - y0_ + 1, max_x - min_x + 1};
+}
+
+template <class Cells>
+void LifeCanvas<Cells>::write(const Extent& box, uint8_t* out) const {
+    constexpr int C = Cells::CELLS;
+
+    // 画布 -> 字节，行间相互独立
+    #pragma omp parallel for num_threads(4) schedule(static) if(box.h * box.w >= 65536)
+    for (int64_t y = 0; y < box.h; ++y) {
+        const Word* r = row(cur_, int(box.y0 + y));
+        uint8_t* dst = out + y * box.w;
+        for (int64_t x = 0; x < box.w; ++x) {
+            const int64_t cx = box.x0 + x;
+            dst[x] = uint8_t((r[cx / C] >> (cx % C)) & 1);
+        }
+    }
+}
+
+template <class Cells>
+static void advance(LifeCanvas<Cells>& life, int generations, int time_block) {
+    for (int it = 0; it < generations; it += time_block) {
+        // 全 0 或稳态提前退出；块内提前稳定不影响结果
+        if (!life.step_block(std::min(time_block, generations - it))) break;
+    }
+}
+
+// ---------- 稀疏块引擎：只重算上一代变化过的 64x64 块及其邻居 ----------
+
+/**
+ * Next generation of a 64x64 bit tile
+ *
+ * c[1..64] are the tile rows, c[0] / c[65] the adjacent rows of the tiles
+ * above / below; w and e hold the same rows of the west / east neighbours
+ * (only their bit 63 / bit 0 is used).
+ *
+ * @return non-zero iff a cell changed
+ */
+LIFE_TARGET_CLONES
+static uint64_t life_tile_bits(const uint64_t* __restrict c, const uint64_t* __restrict w,
+                               const uint64_t* __restrict e, uint64_t* __restrict out) {
+    // 一次 4 行
+    u64x4 changed_v = {0, 0, 0, 0};
+    for (int y = 0; y < 64; y += 4) {
+        const u64x4 n = load_u64x4(c + y),     nw = load_u64x4(w + y),     ne = load_u64x4(e + y);
+        const u64x4 m = load_u64x4(c + y + 1), mw = load_u64x4(w + y + 1), me = load_u64x4(e + y + 1);
+        const u64x4 s = load_u64x4(c + y + 2), sw = load_u64x4(w + y + 2), se = load_u64x4(e + y + 2);
+        const u64x4 next = life_word<u64x4>((n << 1) | (nw >> 63), n, (n >> 1) | (ne << 63),
+                                            (m << 1) | (mw >> 63), m, (m >> 1) | (me << 63),
+                                            (s << 1) | (sw >> 63), s, (s >> 1) | (se << 63));
+        store_u64x4(out + y, next);
+        changed_v |= next ^ m;
+    }
+    return changed_v[0] | changed_v[1] | changed_v[2] | changed_v[3];
+}
+
+/**
+ * Unbounded Life on 64x64 tiles kept in a hash map
+ *
+ * Only tiles that changed in the previous generation and their eight
+ * neighbours are recomputed, so still lifes and empty space cost nothing
+ * and the work scales with activity rather than with the bounding box.
+ * A missing neighbour is allocated only when live cells touch that side,
+ * and tiles that are empty and unchanged are freed.
+ */
+class TileLife {
+public:
+    explicit TileLife(const CellView& grid);
+
+    /** Advance one generation; false once the pattern is empty or stopped changing */
+    bool step();
+
+    /** Bounding box of the live cells */
+    Extent extent() const;
+
+    /** Write the cells of box (from extent()) as 0/1 bytes, box.h x box.w row-major */
+    void write(const Extent& box, uint8_t* out) const;
+
+    size_t tile_count() const { return tiles_.size(); }
+
+private:
+    static constexpr int T = 64;   // 块边长 = uint64_t 的位数，一行一个字
+
+    struct Tile {
+        int32_t ty = 0, tx = 0;
+        uint64_t rows[2][T] = {};  // 乒乓缓冲，rows[cur] 是当前代
+        uint8_t cur = 0;
+        bool changed = false;
+        bool live = false;
+        uint32_t stamp = 0;        // 最近一次被选中重算的代数
+    };
+
+    static uint64_t key(int32_t ty, int32_t tx) { return uint64_t(uint32_t(ty)) << 32 | uint32_t(tx); }
+    const Tile* find(int32_t ty, int32_t tx) const;
+    Tile& get(int32_t ty, int32_t tx);
+    void step_tile(Tile& t) const;
+
+    std::unordered_map<uint64_t, Tile> tiles_;   // 元素地址在插入/删除其他元素时不变
+    std::vector<Tile*> changed_;                 // 上一代变化过的块
+    uint32_t gen_ = 0;
+};
+
+TileLife::TileLife(const CellView& grid) {
+    for (int y = 0; y < grid.h; ++y) {
+        const uint8_t* src = grid.row(y);
+        for (int x = 0; x < grid.w; ++x) {
+            if (!src[x]) continue;
+            Tile& t = get(y / T, x / T);
+            t.rows[0][y % T] |= uint64_t(1) << (x % T);
+        }
+    }
+    // 初始时每个块都算作刚变化
+    for (auto& kv : tiles_) changed_.push_back(&kv.second);
+}
+
+const TileLife::Tile* TileLife::find(int32_t ty, int32_t tx) const {
+    auto it = tiles_.find(key(ty, tx));
+    return it == tiles_.end() ? nullptr : &it->second;
+}
+
+TileLife::Tile& TileLife::get(int32_t ty, int32_t tx) {
+    Tile& t = tiles_[key(ty, tx)];
+    t.ty = ty;
+    t.tx = tx;
+    return t;
+}
+
+void TileLife::step_tile(Tile& t) const {
+    const uint64_t* nb[3][3];
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            const Tile* o = (dy || dx) ? find(t.ty + dy, t.tx + dx) : &t;
+            nb[dy + 1][dx + 1] = o ? o->rows[o->cur] : nullptr;
+        }
+    }
+
+    // 拼出 66 行：上邻块末行、本块 64 行、下邻块首行；西/东列同样
+    alignas(32) uint64_t c[T + 2], w[T + 2], e[T + 2];
+    for (int k = 0; k < 3; ++k) {
+        uint64_t* dst = (k == 0) ? w : (k == 1) ? c : e;
+        dst[0] = nb[0][k] ? nb[0][k][T - 1] : 0;
+        if (nb[1][k]) std::memcpy(dst + 1, nb[1][k], sizeof(uint64_t) * T);
+        else std::memset(dst + 1, 0, sizeof(uint64_t) * T);
+        dst[T + 1] = nb[2][k] ? nb[2][k][0] : 0;
+    }
+
+    uint64_t* out = t.rows[t.cur ^ 1];
+    t.changed = life_tile_bits(c, w, e, out) != 0;
+    uint64_t any = 0;
+    for (int y = 0; y < T; ++y) any |= out[y];
+    t.live = any != 0;
+}
+
+bool TileLife::step() {
+    if (changed_.empty()) return false;
+    ++gen_;
+
+    // 1) 选块：变化块本身及 8 个邻居；缺失的邻居只在细胞贴着对应边/角时才建
+    std::vector<Tile*> work;
+    for (Tile* t : changed_) {
+        const uint64_t* r = t->rows[t->cur];
+        uint64_t cols = 0;
+        for (int y = 0; y < T; ++y) cols |= r[y];
+        const bool edge_n = r[0] != 0, edge_s = r[T - 1] != 0;
+        const bool edge_w = (cols & 1) != 0, edge_e = (cols >> 63) != 0;
+        const bool corner[3][3] = {
+            {(r[0] & 1) != 0,     edge_n, (r[0] >> 63) != 0},
+            {edge_w,              true,   edge_e},
+            {(r[T - 1] & 1) != 0, edge_s, (r[T - 1] >> 63) != 0},
+        };
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                Tile* o;
+                if (!dy && !dx) {
+                    o = t;
+                } else {
+                    auto it = tiles_.find(key(t->ty + dy, t->tx + dx));
+                    if (it != tiles_.end()) o = &it->second;
+                    else if (corner[dy + 1][dx + 1]) o = &get(t->ty + dy, t->tx + dx);
+                    else continue;
                 }
-                const int alive_i = (int)prow[x];
-                const uint8_t nxt = (s == 3 || (s == 2 && alive_i == 1)) ? 1u : 0u;
-                outrow[x] = nxt;
-
-                if (nxt) {
-                    if (y < local_min_y) local_min_y = y;
-                    if (x < local_min_x) local_min_x = x;
-                    if (y > local_max_y) local_max_y = y;
-                    if (x > local_max_x) local_max_x = x;
+                if (o->stamp != gen_) {
+                    o->stamp = gen_;
+                    work.push_back(o);
                 }
             }
-        } // end for y
-
-        // 合并到全局 bbox
-        if (local_max_y >= 0) {
-            #pragma omp critical
-            {
-                if (local_min_y < g_min_y) g_min_y = local_min_y;
-                if (local_min_x < g_min_x) g_min_x = local_min_x;
-                if (local_max_y > g_max_y) g_max_y = local_max_y;
-                if (local_max_x > g_max_x) g_max_x = local_max_x;
+        }
+    }
+
+    // 2) 各块写自己的备用缓冲，只读邻居的当前缓冲，可并行
+    const int n_work = static_cast<int>(work.size());
+    #pragma omp parallel for num_threads(4) schedule(dynamic, 8) if(n_work >= 64)
+    for (int i = 0; i < n_work; ++i) step_tile(*work[i]);
+
+    // 3) 翻转；空且不再变化的块释放（变化过的空块还要让邻居再算一代）
+    changed_.clear();
+    for (Tile* t : work) {
+        t->cur ^= 1;
+        if (t->changed) changed_.push_back(t);
+        else if (!t->live) tiles_.erase(key(t->ty, t->tx));
+    }
+    return !changed_.empty();
+}
+
+Extent TileLife::extent() const {
+    int64_t min_y = std::numeric_limits<int64_t>::max(), max_y = std::numeric_limits<int64_t>::min();
+    int64_t min_x = min_y, max_x = max_y;
+    for (const auto& kv : tiles_) {
+        const Tile& t = kv.second;
+        const uint64_t* r = t.rows[t.cur];
+        for (int y = 0; y < T; ++y) {
+            if (!r[y]) continue;
+            min_y = std::min(min_y, int64_t(t.ty) * T + y);
+            max_y = std::max(max_y, int64_t(t.ty) * T + y);
+            min_x = std::min(min_x, int64_t(t.tx) * T + __builtin_ctzll(r[y]));
+            max_x = std::max(max_x, int64_t(t.tx) * T + 63 - __builtin_clzll(r[y]));
+        }
+    }
+    if (max_y < min_y) return {};
+    return {min_y, min_x, max_y - min_y + 1, max_x - min_x + 1};
+}
+
+void TileLife::write(const Extent& box, uint8_t* out) const {
+    if (box.h == 0) return;
+    std::memset(out, 0, size_t(box.h * box.w));
+    for (const auto& kv : tiles_) {
+        const Tile& t = kv.second;
+        const uint64_t* r = t.rows[t.cur];
+        for (int y = 0; y < T; ++y) {
+            for (uint64_t bits = r[y]; bits; bits &= bits - 1) {
+                const int x = __builtin_ctzll(bits);
+                out[(int64_t(t.ty) * T + y - box.y0) * box.w + int64_t(t.tx) * T + x - box.x0] = 1;
             }
         }
-    } // end parallel for
+    }
+}
+
+static void advance(TileLife& life, int generations) {
+    for (int it = 0; it < generations; ++it) {
+        if (!life.step()) break;   // 全 0 或稳态提前退出
+    }
+}
+
+// ---------- Hashlife：哈希共享的四叉树，结果按 (节点, 步长) 缓存 ----------
+
+/**
+ * Hashlife: the universe as a canonical quadtree
+ *
+ * Every node is a square of 2^level cells. Identical squares are stored once
+ * (hash-consed on their four children), so the result cache of a node (its
+ * centre half advanced 2^j generations) is shared by every place and every
+ * time the square occurs. Periodic patterns and spaceships then cost
+ * roughly log(generations) instead of generations.
+ *
+ * The full-speed result (j = level - 2) lives in the node, results for
+ * smaller j in a side table, so jumps of several sizes do not evict each
+ * other.
+ *
+ * The node pool is bounded: once more than max_nodes nodes are live, the
+ * next step() collects every node not reachable from the pattern or from a
+ * step() still running (those keep their nodes on a pin stack). Node ids
+ * never move; freed ids are reused, and cached results pointing at them are
+ * dropped. If collection cannot get below max_nodes the next one waits
+ * until the live count has doubled, so the pool stays within
+ * max(max_nodes, 2 x live nodes).
+ */
+class HashLife {
+public:
+    static constexpr size_t DEFAULT_MAX_NODES = size_t(1) << 22;
+
+    explicit HashLife(const CellView& grid, size_t max_nodes = DEFAULT_MAX_NODES);
+
+    /** Advance 2^j generations */
+    void advance_pow2(int j);
+
+    /** Advance any number of generations, one power-of-two jump per set bit */
+    void advance(uint64_t generations);
+
+    /** Bounding box of the live cells */
+    Extent extent() const;
+
+    /** Write the cells of box (from extent()) as 0/1 bytes, box.h x box.w row-major */
+    void write(const Extent& box, uint8_t* out) const;
+
+    /** Live nodes (pool size minus freed ids) */
+    size_t node_count() const { return nodes_.size() - free_.size(); }
+
+private:
+    struct Node {
+        uint32_t nw, ne, sw, se;        // 子节点；叶子（level 0）为 0
+        uint32_t result;                // 中心 2^(level-1) 推进 2^(level-2) 代后的节点
+        int8_t level;                   // -1：已释放，在 free_ 中
+        int8_t result_j;                // -1：无缓存
+        uint64_t pop;                   // 活细胞数
+    };
+
+    struct Key {
+        uint32_t nw, ne, sw, se;
+        bool operator==(const Key& o) const { return nw == o.nw && ne == o.ne && sw == o.sw && se == o.se; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint64_t h = (uint64_t(k.nw) << 32 | k.ne) * 0x9E3779B97F4A7C15ull;
+            h ^= (uint64_t(k.sw) << 32 | k.se) * 0xC2B2AE3D27D4EB4Full;
+            return size_t(h ^ (h >> 29));
+        }
+    };
+
+    static constexpr uint32_t DEAD = 0, ALIVE = 1;   // 两个叶子
 
-    // 3) 若全 0，返回空
-    if (g_max_y < 0) return {};
+    uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    uint32_t empty(int level);
+    uint32_t centre(uint32_t n);
+    uint32_t expand(uint32_t n);
+    uint32_t step(uint32_t n, int j);
+    uint32_t step_level2(uint32_t n);
+    uint32_t build(const CellView& grid, int y, int x, int level);
+    void collect(uint32_t n, int64_t y, int64_t x, std::vector<std::pair<int64_t, int64_t>>& cells) const;
+    void collect_garbage();
 
-    // 4) 裁剪（仍在 padded 平面）
-    const int out_h = g_max_y - g_min_y + 1;
-    const int out_w = g_max_x - g_min_x + 1;
-    std::vector<std::vector<char>> out(out_h, std::vector<char>(out_w, 0));
-    for (int y = 0; y < out_h; ++y) {
-        const uint8_t* src_row = next_padded.data() + (g_min_y + y) * stride + g_min_x;
-        std::memcpy(out[y].data(), src_row, size_t(out_w));
+    std::vector<Node> nodes_;
+    std::unordered_map<Key, uint32_t, KeyHash> table_;
+    std::vector<uint32_t> empty_;       // 各层的空节点
+    std::unordered_map<uint64_t, uint32_t> results_;   // (节点 << 8 | j) -> 结果，j < level - 2
+    std::vector<uint32_t> pins_;        // 运行中的 step() 持有的节点，回收时视为根
+    std::vector<uint32_t> free_;        // 已释放、可复用的编号
+    uint32_t root_ = DEAD;
+    size_t max_nodes_;
+    size_t gc_at_;                      // 活节点数超过它时回收
+};
+
+HashLife::HashLife(const CellView& grid, size_t max_nodes) : max_nodes_(max_nodes), gc_at_(max_nodes) {
+    nodes_.push_back({0, 0, 0, 0, 0, 0, -1, 0});   // DEAD
+    nodes_.push_back({0, 0, 0, 0, 0, 0, -1, 1});   // ALIVE
+    empty_.push_back(DEAD);
+
+    int level = 1;
+    while ((1 << level) < std::max(grid.h, grid.w)) ++level;
+    root_ = build(grid, 0, 0, level);
+}
+
+uint32_t HashLife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    const Key key{nw, ne, sw, se};
+    auto it = table_.find(key);
+    if (it != table_.end()) return it->second;
+
+    const uint64_t pop = nodes_[nw].pop + nodes_[ne].pop + nodes_[sw].pop + nodes_[se].pop;
+    const Node node{nw, ne, sw, se, 0, int8_t(nodes_[nw].level + 1), -1, pop};
+    uint32_t id;
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+        nodes_[id] = node;
+    } else {
+        id = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(node);
     }
-    return out;
+    table_.emplace(key, id);
+    return id;
+}
+
+uint32_t HashLife::empty(int level) {
+    while (int(empty_.size()) <= level) {
+        const uint32_t e = empty_.back();
+        empty_.push_back(join(e, e, e, e));
+    }
+    return empty_[level];
+}
+
+uint32_t HashLife::centre(uint32_t n) {
+    const Node nd = nodes_[n];
+    return join(nodes_[nd.nw].se, nodes_[nd.ne].sw, nodes_[nd.sw].ne, nodes_[nd.se].nw);
+}
+
+uint32_t HashLife::expand(uint32_t n) {
+    // 原节点放在中心，四周补空白
+    const Node nd = nodes_[n];
+    const uint32_t e = empty(nd.level - 1);
+    return join(join(e, e, e, nd.nw), join(e, e, nd.ne, e),
+                join(e, nd.sw, e, e), join(nd.se, e, e, e));
+}
+
+uint32_t HashLife::build(const CellView& grid, int y, int x, int level) {
+    if (y >= grid.h || x >= grid.w) return empty(level);
+    if (level == 0) return grid.row(y)[x] ? ALIVE : DEAD;
+    const int half = 1 << (level - 1);
+    return join(build(grid, y, x, level - 1), build(grid, y, x + half, level - 1),
+                build(grid, y + half, x, level - 1), build(grid, y + half, x + half, level - 1));
 }
 
-// ---------- 多步：入口 int 矩阵 -> 转 char；中间全部 char；出口再转回 int ----------
+uint32_t HashLife::step_level2(uint32_t n) {
+    // 4x4 直接按规则算中心 2x2
+    const Node nd = nodes_[n];
+    const uint32_t quads[4] = {nd.nw, nd.ne, nd.sw, nd.se};
+    int cells[4][4];
+    for (int q = 0; q < 4; ++q) {
+        const Node& c = nodes_[quads[q]];
+        const int y = (q >> 1) * 2, x = (q & 1) * 2;
+        cells[y][x] = int(c.nw == ALIVE);     cells[y][x + 1] = int(c.ne == ALIVE);
+        cells[y + 1][x] = int(c.sw == ALIVE); cells[y + 1][x + 1] = int(c.se == ALIVE);
+    }
+    uint32_t out[4];
+    for (int i = 0; i < 4; ++i) {
+        const int y = 1 + (i >> 1), x = 1 + (i & 1);
+        int s = 0;
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx)
+                if (dy || dx) s += cells[y + dy][x + dx];
+        out[i] = (s == 3 || (s == 2 && cells[y][x])) ? ALIVE : DEAD;
+    }
+    return join(out[0], out[1], out[2], out[3]);
+}
+
+/**
+ * Centre half of node n advanced 2^j generations, j <= level - 2
+ *
+ * The nine overlapping sub-squares of half size are stepped and recombined.
+ * At full speed (j = level - 2) both halves of the time come from recursive
+ * steps; for smaller j the first stage only takes centres and the second
+ * stage advances the whole 2^j.
+ */
+uint32_t HashLife::step(uint32_t n, int j) {
+    const Node nd = nodes_[n];
+    if (nd.pop == 0) return empty(nd.level - 1);
+    if (nd.result_j == j) return nd.result;
+    const bool full = (j == nd.level - 2);
+    const uint64_t key = uint64_t(n) << 8 | uint64_t(j);
+    if (!full && nd.result_j >= 0) {
+        auto it = results_.find(key);
+        if (it != results_.end()) return it->second;
+    }
+
+    // 调用者手里的节点都已钉住，这里回收是安全的；编号不移动，nd 仍然有效
+    const size_t base = pins_.size();
+    pins_.push_back(n);
+    if (node_count() > gc_at_) collect_garbage();
+
+    uint32_t r;
+    if (nd.level == 2) {
+        r = step_level2(n);
+    } else {
+        // 九个半尺寸子方块放在 pins_[base + 1 ..]；递归会让 pins_ 扩容，只能按下标访问
+        const Node a = nodes_[nd.nw], b = nodes_[nd.ne], c = nodes_[nd.sw], d = nodes_[nd.se];
+        pins_.push_back(nd.nw);
+        pins_.push_back(join(a.ne, b.nw, a.se, b.sw));
+        pins_.push_back(nd.ne);
+        pins_.push_back(join(a.sw, a.se, c.nw, c.ne));
+        pins_.push_back(join(a.se, b.sw, c.ne, d.nw));
+        pins_.push_back(join(b.sw, b.se, d.nw, d.ne));
+        pins_.push_back(nd.sw);
+        pins_.push_back(join(c.ne, d.nw, c.se, d.sw));
+        pins_.push_back(nd.se);
+        const size_t m = base + 1;
+        for (size_t i = 0; i < 9; ++i) {
+            const uint32_t q = full ? step(pins_[m + i], j - 1) : centre(pins_[m + i]);
+            pins_[m + i] = q;
+        }
+
+        const int j2 = full ? j - 1 : j;
+        static constexpr int QUAD[4][4] = {{0, 1, 3, 4}, {1, 2, 4, 5}, {3, 4, 6, 7}, {4, 5, 7, 8}};
+        for (const auto& q : QUAD) {
+            const uint32_t s = step(join(pins_[m + q[0]], pins_[m + q[1]], pins_[m + q[2]], pins_[m + q[3]]), j2);
+            pins_.push_back(s);
+        }
+        r = join(pins_[m + 9], pins_[m + 10], pins_[m + 11], pins_[m + 12]);
+    }
+    pins_.resize(base);
+
+    // 节点内的槽优先给全速结果；被挤出或放不下的步长进 results_
+    Node& slot = nodes_[n];
+    if (slot.result_j < 0 || full) {
+        if (slot.result_j >= 0) results_[uint64_t(n) << 8 | uint64_t(slot.result_j)] = slot.result;
+        slot.result = r;
+        slot.result_j = int8_t(j);
+    } else {
+        results_[key] = r;
+    }
+    return r;
+}
+
+void HashLife::advance_pow2(int j) {
+    if (nodes_[root_].pop == 0) return;
+
+    // 图案须在中心一半以内，再外扩一层，保证推进 2^j 代后仍在结果节点内
+    while (nodes_[root_].level < j + 2 || nodes_[centre(root_)].pop != nodes_[root_].pop) {
+        root_ = expand(root_);
+    }
+    root_ = step(expand(root_), j);
+}
+
+void HashLife::advance(uint64_t generations) {
+    for (int j = 0; generations >> j; ++j) {
+        if ((generations >> j) & 1) advance_pow2(j);
+    }
+}
+
+void HashLife::collect_garbage() {
+    // 标记从 root_、空节点和运行中的 step() 可达的节点
+    std::vector<char> live(nodes_.size(), 0);
+    std::vector<uint32_t> stack(empty_.begin(), empty_.end());
+    stack.insert(stack.end(), pins_.begin(), pins_.end());
+    stack.push_back(root_);
+    live[DEAD] = live[ALIVE] = 1;
+    while (!stack.empty()) {
+        const uint32_t n = stack.back();
+        stack.pop_back();
+        if (live[n]) continue;
+        live[n] = 1;
+        const Node& nd = nodes_[n];
+        stack.insert(stack.end(), {nd.nw, nd.ne, nd.sw, nd.se});
+    }
+
+    // 其余节点编号进 free_；活节点的子节点必然活着，哈希表里只删死节点
+    for (uint32_t n = 0; n < nodes_.size(); ++n) {
+        Node& nd = nodes_[n];
+        if (live[n]) {
+            if (nd.result_j >= 0 && !live[nd.result]) nd.result_j = -1;
+        } else if (nd.level >= 0) {
+            table_.erase(Key{nd.nw, nd.ne, nd.sw, nd.se});
+            nd.level = -1;
+            nd.result_j = -1;
+            free_.push_back(n);
+        }
+    }
+    for (auto it = results_.begin(); it != results_.end();) {
+        if (live[it->first >> 8] && live[it->second]) ++it;
+        else it = results_.erase(it);
+    }
+    gc_at_ = std::max(max_nodes_, 2 * node_count());
+}
+
+void HashLife::collect(uint32_t n, int64_t y, int64_t x, std::vector<std::pair<int64_t, int64_t>>& cells) const {
+    const Node& nd = nodes_[n];
+    if (nd.pop == 0) return;
+    if (nd.level == 0) {
+        cells.emplace_back(y, x);
+        return;
+    }
+    const int64_t half = int64_t(1) << (nd.level - 1);
+    collect(nd.nw, y, x, cells);
+    collect(nd.ne, y, x + half, cells);
+    collect(nd.sw, y + half, x, cells);
+    collect(nd.se, y + half, x + half, cells);
+}
+
+Extent HashLife::extent() const {
+    std::vector<std::pair<int64_t, int64_t>> cells;
+    collect(root_, 0, 0, cells);
+    if (cells.empty()) return {};
+
+    int64_t min_y = cells[0].first, max_y = min_y, min_x = cells[0].second, max_x = min_x;
+    for (const auto& c : cells) {
+        min_y = std::min(min_y, c.first);  max_y = std::max(max_y, c.first);
+        min_x = std::min(min_x, c.second); max_x = std::max(max_x, c.second);
+    }
+    return {min_y, min_x, max_y - min_y + 1, max_x - min_x + 1};
+}
+
+void HashLife::write(const Extent& box, uint8_t* out) const {
+    if (box.h == 0) return;
+    std::vector<std::pair<int64_t, int64_t>> cells;
+    collect(root_, 0, 0, cells);
+    std::memset(out, 0, size_t(box.h * box.w));
+    for (const auto& c : cells) out[(c.first - box.y0) * box.w + c.second - box.x0] = 1;
+}
+
+static void advance(HashLife& life, int generations) {
+    // 稳态或全 0 之后再推进结果不变，与逐代提前退出一致
+    life.advance(uint64_t(std::max(generations, 0)));
+}
+
+// ---------- 多步：入口字节网格 -> 引擎；中间不再分配；出口按包围盒写回 ----------
+
+/** A finished run of one engine, read back through extent() / write() */
+class Simulation {
+public:
+    virtual ~Simulation() = default;
+
+    /** Bounding box of the live cells */
+    virtual Extent extent() const = 0;
+
+    /** Write the cells of box as 0/1 bytes, box.h x box.w row-major */
+    virtual void write(const Extent& box, uint8_t* out) const = 0;
+};
+
+template <class Life>
+class SimulationOf : public Simulation {
+public:
+    explicit SimulationOf(const CellView& grid) : life(grid) {}
+    Extent extent() const override { return life.extent(); }
+    void write(const Extent& box, uint8_t* out) const override { life.write(box, out); }
+
+    Life life;
+};
+
+template <class Life, class... Args>
+static std::unique_ptr<Simulation> run(const CellView& grid, Args... args) {
+    auto sim = std::make_unique<SimulationOf<Life>>(grid);
+    advance(sim->life, args...);
+    return sim;
+}
+
+/**
+ * @param engine  "bitpack" (64 cells per word, default), "char" (one byte per
+ *                cell), "sparse" (only active 64x64 tiles) or "hashlife"
+ *                (memoized quadtree, for long runs)
+ * @param time_block  Generations per pass over memory for bitpack / char
+ *                    (temporal blocking), 1 = one pass per generation;
+ *                    capped at LifeCanvas::MAX_TIME_BLOCK
+ * @throws std::invalid_argument for other engine names or time_block < 1
+ */
+static std::unique_ptr<Simulation> simulate(const CellView& grid, int generations,
+                                            const std::string& engine, int time_block) {
+    if (time_block < 1) throw std::invalid_argument("time_block must be >= 1");
+    // 画布边距、草稿和冗余的晕圈计算都随 T 增长，超过上限没有收益
+    time_block = std::min(time_block, LifeCanvas<BitCells>::MAX_TIME_BLOCK);
+    if (engine == "bitpack")  return run<LifeCanvas<BitCells>>(grid, generations, time_block);
+    if (engine == "char")     return run<LifeCanvas<ByteCells>>(grid, generations, time_block);
+    if (engine == "sparse")   return run<TileLife>(grid, generations);
+    if (engine == "hashlife") return run<HashLife>(grid, generations);
+    throw std::invalid_argument("Unknown engine: " + engine + " (expected bitpack, char, sparse, hashlife)");
+}
+
+/** List interface: int rows in, int rows cropped to the live cells out */
 std::vector<std::vector<int>> expand_cpp(
     const std::vector<std::vector<int>>& initial_grid,
-    int generations) {
+    int generations,
+    const std::string& engine,
+    int time_block) {
 
-    // int -> char（更小带宽，提升 cache locality）
-    const int h0 = static_cast<int>(initial_grid.size());
-    const int w0 = (h0 > 0) ? static_cast<int>(initial_grid[0].size()) : 0;
-
-    std::vector<std::vector<char>> cur_char(h0, std::vector<char>(w0, 0));
-    for (int y = 0; y < h0; ++y) {
+    // 入口拍平成字节；行长以首行为准
+    CellView view;
+    view.h = static_cast<int>(initial_grid.size());
+    view.w = (view.h > 0) ? static_cast<int>(initial_grid[0].size()) : 0;
+    view.stride = view.w;
+    std::vector<uint8_t> cells(size_t(view.h) * view.w, 0);
+    for (int y = 0; y < view.h; ++y) {
         const std::vector<int>& src = initial_grid[y];
-        char* dst = cur_char[y].data();
-        for (int x = 0; x < w0; ++x) dst[x] = static_cast<char>(src[x] != 0);
+        const int n = std::min(view.w, static_cast<int>(src.size()));
+        for (int x = 0; x < n; ++x) cells[size_t(y) * view.w + x] = uint8_t(src[x] != 0);
     }
+    view.data = cells.data();
 
-    for (int it = 0; it < generations; ++it) {
-        auto next_char = next_generation_char(cur_char);
-        if (equal_grid_char(next_char, cur_char)) {
-            cur_char.swap(next_char);
-            break; // 稳态提前退出
-        }
-        cur_char.swap(next_char);
-        if (cur_char.empty()) break; // 全 0
+    Extent box;
+    std::vector<uint8_t> flat;
+    {
+        py::gil_scoped_release release;
+        const std::unique_ptr<Simulation> sim = simulate(view, generations, engine, time_block);
+        box = sim->extent();
+        flat.resize(size_t(box.h * box.w));
+        sim->write(box, flat.data());
+    }
+
+    std::vector<std::vector<int>> out(size_t(box.h), std::vector<int>(size_t(box.w)));
+    for (int64_t y = 0; y < box.h; ++y) {
+        std::copy(flat.begin() + y * box.w, flat.begin() + (y + 1) * box.w, out[size_t(y)].begin());
+    }
+    return out;
+}
+
+/**
+ * NumPy interface: a 2-D array in (read in place when it is C-contiguous
+ * uint8 or bool, otherwise converted once; non-zero = alive), a new uint8
+ * array cropped to the live cells out
+ *
+ * @throws std::invalid_argument for arrays that are not 2-D, and as expand_cpp
+ */
+py::array_t<uint8_t> expand_numpy(
+    py::array initial_grid,
+    int generations,
+    const std::string& engine,
+    int time_block) {
+
+    // uint8 / bool 按字节原地读取；其他类型转换一次成 bool，即非 0 存活（强转 uint8 会把 256、0.5 截成 0）
+    const py::dtype dt = initial_grid.dtype();
+    py::array grid;
+    if (dt.itemsize() == 1 && (dt.kind() == 'u' || dt.kind() == 'b')) {
+        grid = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>::ensure(initial_grid);
+    } else {
+        grid = py::array_t<bool, py::array::c_style | py::array::forcecast>::ensure(initial_grid);
     }
+    if (!grid || grid.ndim() != 2) throw std::invalid_argument("initial_grid must be a 2-D array");
 
-    // char -> int（返回值与接口保持一致）
-    std::vector<std::vector<int>> out;
-    out.resize(cur_char.size());
-    for (size_t y = 0; y < cur_char.size(); ++y) {
-        out[y].resize(cur_char[y].size());
-        const char* src = cur_char[y].data();
-        int* dst = out[y].data();
-        for (size_t x = 0; x < cur_char[y].size(); ++x) dst[x] = (src[x] != 0) ? 1 : 0;
+    CellView view;
+    view.data = static_cast<const uint8_t*>(grid.data());
+    view.h = static_cast<int>(grid.shape(0));
+    view.w = static_cast<int>(grid.shape(1));
+    view.stride = view.w;
+
+    // 模拟与写回都不碰 Python 对象，只有分配输出数组时持有 GIL
+    std::unique_ptr<Simulation> sim;
+    Extent box;
+    {
+        py::gil_scoped_release release;
+        sim = simulate(view, generations, engine, time_block);
+        box = sim->extent();
+    }
+    py::array_t<uint8_t> out({py::ssize_t(box.h), py::ssize_t(box.w)});
+    uint8_t* dst = out.mutable_data();
+    {
+        py::gil_scoped_release release;
+        sim->write(box, dst);
     }
     return out;
 }
 
 
 PYBIND11_MODULE(NG, m) {
+    // ndarray 重载先注册：否则 ndarray 会被当作序列逐元素转换成 list
+    m.def("Expand_Cpp", &expand_numpy,
+          "Simulate multiple generations of Conway's Game of Life on a 2-D NumPy array (uint8 result)",
+          py::arg("initial_grid").noconvert(), py::arg("generations"), py::arg("engine") = "bitpack",
+          py::arg("time_block") = 1);
     m.def("Expand_Cpp", &expand_cpp,
           "Simulate multiple generations of Conway's Game of Life and return all intermediate states",
-          py::arg("initial_grid"), py::arg("generations"));
+          py::arg("initial_grid"), py::arg("generations"), py::arg("engine") = "bitpack",
+          py::arg("time_block") = 1);
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+import argparse, random, time
+
+import NG
+
+# Cells/s of the canvas engines versus the temporal block size T
+# (generations advanced per pass over memory, see LifeCanvas::step_block)
+
+def main():
+    parser = argparse.ArgumentParser(description="Temporal blocking benchmark: cells/s versus T.")
+    parser.add_argument('-S', '--size', type=int, default=4096, help='Side of the random square grid.')
+    parser.add_argument('-I', '--iter', type=int, default=64, help='Generations per run.')
+    parser.add_argument('-E', '--engine', choices=['bitpack', 'char'], default='bitpack', help='C++ engine.')
+    parser.add_argument('-T', '--time-blocks', type=str, default='1,2,4,8,16,32',
+                        help='Comma-separated block sizes to compare.')
+    parser.add_argument('--seed', type=int, default=1, help='Seed of the random grid.')
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    n = args.size
+    grid = [[random.getrandbits(1) for _ in range(n)] for _ in range(n)]
+
+    # 0 代的调用只做 list <-> C++ 的转换，从每次计时里扣掉
+    start = time.perf_counter()
+    NG.Expand_Cpp(grid, 0, args.engine)
+    convert = time.perf_counter() - start
+
+    cells = float(n) * n * args.iter
+    reference = None
+    print(f"{args.engine} {n}x{n}, {args.iter} generations, conversion {convert:.4f} s")
+    for t in [int(v) for v in args.time_blocks.split(',')]:
+        start = time.perf_counter()
+        ans = NG.Expand_Cpp(grid, args.iter, args.engine, t)
+        elapsed = max(time.perf_counter() - start - convert, 1e-9)
+        if reference is None:
+            reference = ans
+        status = "" if ans == reference else "  MISMATCH"
+        print(f"T={t:3d}  {elapsed:.4f} s  {cells / elapsed * 1e-6:10.1f} Mcells/s{status}")
+
+
+if __name__ == "__main__":
+    main()
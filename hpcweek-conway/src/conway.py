@@ -176,6 +176,19 @@ def Expand_Ref(grid, iter):
 #     return cur.tolist()
 
 import NG 
-def Expand(grid, iter):
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+def Expand(grid, iter, engine="bitpack", time_block=1):
     # Implement your own version to calculate the final grid
-    return NG.Expand_Cpp(grid, iter)
\ No newline at end of file
+    # engine: bitpack / char / sparse / hashlife, see NG.cpp
+    # time_block: generations per pass over memory (bitpack / char)
+    # ndarray 进 -> uint8 ndarray 出，C++ 直接读写数组缓冲区
+    if np is not None and isinstance(grid, np.ndarray):
+        return NG.Expand_Cpp(grid, iter, engine, time_block)
+    # list 进 -> list 出；有 NumPy 时一次转成 uint8 数组，比 pybind11 逐元素转换快
+    if np is not None and grid and grid[0]:
+        return NG.Expand_Cpp(np.asarray(grid, dtype=np.uint8), iter, engine, time_block).tolist()
+    return NG.Expand_Cpp(grid, iter, engine, time_block)
\ No newline at end of file
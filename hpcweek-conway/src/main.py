@@ -86,6 +86,10 @@ def main():
     parser = argparse.ArgumentParser(description="Conway's Game of Life simulation.")
     parser.add_argument('-V', '--visualize', action='store_true', help='Enable visualization.')
     parser.add_argument('-I', '--iter', type=int, default=100, help='Number of iterations.')
+    parser.add_argument('-E', '--engine', choices=['bitpack', 'char', 'sparse', 'hashlife'], default='bitpack',
+                        help='C++ engine: bit-packed, one byte per cell, active 64x64 tiles only, or Hashlife for long runs.')
+    parser.add_argument('-T', '--time-block', type=int, default=1,
+                        help='Generations per pass over memory for the bitpack / char engines (temporal blocking).')
     
     group = parser.add_mutually_exclusive_group(required=True)
     group.add_argument('-F', '--file', type=str, help='Path to an RTE file to load the initial grid.')
@@ -111,7 +115,7 @@ def main():
     end_Ref = time.perf_counter()
     
     start = time.perf_counter()
-    ans = Expand(grid, args.iter)
+    ans = Expand(grid, args.iter, args.engine, args.time_block)
     end = time.perf_counter()
 
     trimmed_ans = trim_grid(ans)
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "angle_weights.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+AngleWeighting parse_angle_weighting(const std::string& name) {
+    if (name == "uniform")    return AngleWeighting::Uniform;
+    if (name == "trapezoid")  return AngleWeighting::Trapezoid;
+    if (name == "redundancy") return AngleWeighting::Redundancy;
+    throw std::invalid_argument("Unknown angle weighting: " + name);
+}
+
+const char* angle_weighting_name(AngleWeighting weighting) {
+    switch (weighting) {
+        case AngleWeighting::Uniform:    return "uniform";
+        case AngleWeighting::Trapezoid:  return "trapezoid";
+        case AngleWeighting::Redundancy: return "redundancy";
+    }
+    return "unknown";
+}
+
+/**
+ * Indices of values in ascending order
+ */
+static std::vector<int> sorted_order(const std::vector<double>& values) {
+    std::vector<int> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+    return order;
+}
+
+/**
+ * Trapezoid d_theta (degrees) of angles taken modulo period_deg
+ */
+static std::vector<double> periodic_trapezoid(const std::vector<float>& angles_deg, double period_deg) {
+    const int n = int(angles_deg.size());
+    std::vector<double> phi(n);
+    for (int i = 0; i < n; ++i) {
+        phi[i] = std::fmod(double(angles_deg[i]), period_deg);
+        if (phi[i] < 0) phi[i] += period_deg;
+    }
+    const std::vector<int> order = sorted_order(phi);
+
+    double max_gap = 0;
+    for (int k = 1; k < n; ++k) max_gap = std::max(max_gap, phi[order[k]] - phi[order[k - 1]]);
+    double wrap = period_deg - (phi[order[n - 1]] - phi[order[0]]);
+    // 缺失楔形：不把空缺摊到两端的视角上（360° 扫描取模后角度成对重合，不能用平均间隔判断）
+    if (max_gap > 0 && wrap > 2 * max_gap) wrap = max_gap;
+
+    std::vector<double> w(n);
+    for (int k = 0; k < n; ++k) {
+        const double prev = k == 0 ? wrap : phi[order[k]] - phi[order[k - 1]];
+        const double next = k == n - 1 ? wrap : phi[order[k + 1]] - phi[order[k]];
+        w[order[k]] = 0.5 * (prev + next);
+    }
+    return w;
+}
+
+std::vector<float> angle_weights(const std::vector<float>& angles_deg,
+    AngleWeighting weighting, double period_deg) {
+    const int n = int(angles_deg.size());
+    if (weighting == AngleWeighting::Redundancy && period_deg != 180.0) {
+        throw std::invalid_argument("Redundancy weighting is implemented for parallel-beam scans only");
+    }
+    std::vector<float> out(n);
+    if (n == 0) return out;
+
+    const double deg2rad = PI / 180.0;
+    if (weighting == AngleWeighting::Uniform || n == 1) {
+        std::fill(out.begin(), out.end(), float(period_deg * deg2rad / n));
+        return out;
+    }
+
+    std::vector<double> w;
+    if (weighting == AngleWeighting::Redundancy) {
+        std::vector<double> theta(angles_deg.begin(), angles_deg.end());
+        const std::vector<int> order = sorted_order(theta);
+
+        // 不取模的梯形权重，两端视角沿用相邻间隔，扫描区间以采样为中心
+        w.resize(n);
+        const double first_gap = theta[order[1]] - theta[order[0]];
+        const double last_gap = theta[order[n - 1]] - theta[order[n - 2]];
+        for (int k = 0; k < n; ++k) {
+            const double prev = k == 0 ? first_gap : theta[order[k]] - theta[order[k - 1]];
+            const double next = k == n - 1 ? last_gap : theta[order[k + 1]] - theta[order[k]];
+            w[order[k]] = 0.5 * (prev + next);
+        }
+        const double start = theta[order[0]] - 0.5 * first_gap;
+        const double delta = theta[order[n - 1]] + 0.5 * last_gap - start - 180.0;
+
+        if (delta >= 180.0) {
+            w = periodic_trapezoid(angles_deg, period_deg);
+        } else if (delta > 0) {
+            // beta 与 beta + 180 测的是同一组射线，两处权重之和为 1
+            for (int i = 0; i < n; ++i) {
+                const double beta = theta[i] - start;
+                double r = 1.0;
+                if (beta < delta) {
+                    r = std::sin(0.5 * PI * beta / delta);
+                    r *= r;
+                } else if (beta > 180.0) {
+                    r = std::cos(0.5 * PI * std::min(beta - 180.0, delta) / delta);
+                    r *= r;
+                }
+                w[i] *= r;
+            }
+        }
+    } else {
+        w = periodic_trapezoid(angles_deg, period_deg);
+    }
+
+    for (int i = 0; i < n; ++i) out[i] = float(w[i] * deg2rad);
+    return out;
+}
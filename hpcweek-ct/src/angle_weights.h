@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include "fbp.h"
+
+/**
+ * Per-angle quadrature weights d_theta (radians) of the backprojection sum
+ *
+ * The weights of one scan add up to pi * (period_deg / 180) for complete
+ * coverage, so Uniform over 180 degrees reproduces the classic pi / n_angles.
+ * Angles may be given in any order.
+ *
+ * Trapezoid: the angles are reduced modulo period_deg and sorted; each one
+ * gets half the gap to its two neighbours, wrapping around the period. If
+ * the scan leaves a missing wedge (wrap gap larger than twice the largest
+ * gap between scanned angles) the wedge is not spread over the end views,
+ * which get that largest gap instead.
+ *
+ * Redundancy: trapezoid d_theta of the sorted angles without wrapping,
+ * multiplied by w(beta) = sin^2(pi/2 * beta/delta) on the first delta and
+ * cos^2(pi/2 * (beta - 180)/delta) on the last delta of a 180 + delta
+ * degree scan, so every direction adds up to weight 1 without the abrupt
+ * steps of plain trapezoid weights. Scans of 360 degrees or more fall back
+ * to Trapezoid.
+ *
+ * @param angles_deg  Projection angles in degrees [n_angles]
+ * @param weighting   Uniform, Trapezoid or Redundancy
+ * @param period_deg  180 for parallel beam, 360 for cone beam
+ * @throws std::invalid_argument for Redundancy with period_deg != 180
+ */
+std::vector<float> angle_weights(const std::vector<float>& angles_deg,
+    AngleWeighting weighting, double period_deg);
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "backproject.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+Geometry make_geometry(int n_angles, int n_det, const std::vector<float>& angles_deg) {
+    const double deg2rad = PI / 180.0;
+    Geometry geo;
+    geo.n_angles = n_angles;
+    geo.n_det = n_det;
+    geo.cos_t.resize(n_angles);
+    geo.sin_t.resize(n_angles);
+    for (int ai = 0; ai < n_angles; ++ai) {
+        double t = double(angles_deg[ai]) * deg2rad;
+        geo.cos_t[ai] = std::cos(t);
+        geo.sin_t[ai] = std::sin(t);
+    }
+    geo.cx = (n_det - 1) * 0.5;
+    geo.cy = (n_det - 1) * 0.5;
+    geo.t_half = (n_det - 1) * 0.5f;
+    return geo;
+}
+
+Backend parse_backend(const std::string& name) {
+    if (name == "auto")    return Backend::Auto;
+    if (name == "scalar")  return Backend::Scalar;
+    if (name == "neon")    return Backend::NEON;
+    if (name == "avx2")    return Backend::AVX2;
+    if (name == "avx512")  return Backend::AVX512;
+    throw std::invalid_argument("Unknown backend: " + name);
+}
+
+const char* backend_name(Backend backend) {
+    switch (backend) {
+        case Backend::Auto:   return "auto";
+        case Backend::Scalar: return "scalar";
+        case Backend::NEON:   return "neon";
+        case Backend::AVX2:   return "avx2";
+        case Backend::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool backend_available(Backend backend) {
+    switch (backend) {
+        case Backend::Auto:
+        case Backend::Scalar:
+            return true;
+        case Backend::NEON:
+#if defined(CT_HAVE_NEON)
+            return true;
+#else
+            return false;
+#endif
+        case Backend::AVX2:
+#if defined(CT_HAVE_AVX2)
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+            return false;
+#endif
+        case Backend::AVX512:
+#if defined(CT_HAVE_AVX512)
+            return __builtin_cpu_supports("avx512f");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+Backend resolve_backend(Backend requested) {
+    if (requested != Backend::Auto) {
+        if (!backend_available(requested)) {
+            throw std::runtime_error(std::string("Backend not available on this host: ") + backend_name(requested));
+        }
+        return requested;
+    }
+    // 按性能从高到低依次探测
+    for (Backend b : {Backend::AVX512, Backend::AVX2, Backend::NEON}) {
+        if (backend_available(b)) return b;
+    }
+    return Backend::Scalar;
+}
+
+BackprojectKernel backproject_kernel(Backend backend) {
+    switch (backend) {
+#if defined(CT_HAVE_NEON)
+        case Backend::NEON:   return backproject_segment_neon;
+#endif
+#if defined(CT_HAVE_AVX2)
+        case Backend::AVX2:   return backproject_segment_avx2;
+#endif
+#if defined(CT_HAVE_AVX512)
+        case Backend::AVX512: return backproject_segment_avx512;
+#endif
+        default:              return backproject_segment_scalar;
+    }
+}
+
+BackprojectFixedKernel backproject_fixed_kernel(Backend backend) {
+    switch (backend) {
+#if defined(CT_HAVE_NEON)
+        case Backend::NEON:   return backproject_fixed_neon;
+#endif
+#if defined(CT_HAVE_AVX2)
+        case Backend::AVX2:   return backproject_fixed_avx2;
+#endif
+#if defined(CT_HAVE_AVX512)
+        case Backend::AVX512: return backproject_fixed_avx512;
+#endif
+        default:              return backproject_fixed_scalar;
+    }
+}
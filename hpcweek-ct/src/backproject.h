@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "fbp.h"
+
+/**
+ * Parallel-beam geometry shared by all slices
+ *
+ * Image row y, pixel x of an angle maps to the detector coordinate
+ * u = (x - cx) * cos_t + (y - cy) * sin_t + t_half.
+ */
+struct Geometry {
+    int n_angles;
+    int n_det;
+    std::vector<double> cos_t, sin_t;
+    double cx, cy;   // Image center
+    float t_half;    // Detector offset to center
+};
+
+/**
+ * @param angles_deg  Projection angles in degrees [n_angles]
+ */
+Geometry make_geometry(int n_angles, int n_det, const std::vector<float>& angles_deg);
+
+/**
+ * Backprojection row-segment kernel
+ *
+ * For one projection angle, accumulates the linearly interpolated detector
+ * values of S slices into S image row segments of n pixels:
+ *
+ *   u(x) = u_start + x * inc                      (evaluated in double)
+ *   recon_rows[b][x] += lerp(sino_rows[b], u(x))  for b < S, x < n
+ *
+ * u is truncated toward zero (u0 = int(u), du = u - u0) and taps outside
+ * [0, n_det) contribute nothing. u is advanced in blocks of 8 pixels exactly
+ * like the original NEON loop, so all backends agree to float rounding.
+ *
+ * @param sino_rows   S detector rows of the current angle; sino_rows[b][0]
+ *                    holds detector index det_offset
+ * @param recon_rows  S output row segments [n] - accumulated into
+ * @param S           Number of slices sharing the coordinates
+ * @param n           Segment length in pixels
+ * @param u_start     Detector coordinate of the first pixel
+ * @param inc         Detector coordinate increment per pixel
+ * @param n_det       Detector row length (bounds for the taps)
+ * @param det_offset  First detector index present in sino_rows (0 for full
+ *                    rows, > 0 when reading a cached detector span)
+ */
+using BackprojectKernel = void (*)(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset);
+
+/**
+ * Scalar remainder shared by all kernels: pixels [x, n), u advanced one
+ * pixel at a time from last_u (du kept in double like the original tail loop)
+ */
+static inline void backproject_segment_tail(const float* const* sino_rows,
+    float* const* recon_rows, int S, int x, int n, double last_u, double inc, int n_det,
+    int det_offset) {
+    for (; x < n; ++x) {
+        double u = last_u;
+        last_u = u + inc;
+
+        int u0 = int(u);
+        float du = u - u0;
+        int u1 = u0 + 1;
+
+        float w0 = (u0 >= 0 && u0 < n_det) ? 1.0f - du : 0.0f;
+        float w1 = (u1 >= 0 && u1 < n_det) ? du : 0.0f;
+        u0 = std::min(std::max(u0, 0), n_det - 1) - det_offset;
+        u1 = std::min(std::max(u1, 0), n_det - 1) - det_offset;
+
+        for (int b = 0; b < S; ++b) {
+            recon_rows[b][x] += sino_rows[b][u0] * w0 + sino_rows[b][u1] * w1;
+        }
+    }
+}
+
+/**
+ * Detector span [lo, lo + len) under the footprint of a pixel rectangle
+ *
+ * u is linear in (x, y), so over [xa, xb] x [ya, yb] (pixel centres relative
+ * to the image centre) its extremes sit on the corners. Two extra taps on
+ * each side cover float rounding and truncation toward zero.
+ *
+ * @return true if the span needed no clamping to [0, n_det), i.e. both taps
+ *         of every pixel of the rectangle are valid detector indices
+ */
+static inline bool detector_span(double xa, double xb, double ya, double yb,
+    double c, double s, float t_half, int n_det, int& lo, int& len) {
+    const double u00 = xa * c + ya * s, u01 = xb * c + ya * s;
+    const double u10 = xa * c + yb * s, u11 = xb * c + yb * s;
+    const double umin = std::min(std::min(u00, u01), std::min(u10, u11)) + t_half;
+    const double umax = std::max(std::max(u00, u01), std::max(u10, u11)) + t_half;
+    const int lo_raw = int(std::floor(umin)) - 2;
+    const int hi_raw = int(std::floor(umax)) + 3;
+    lo = std::min(std::max(lo_raw, 0), n_det - 1);
+    const int hi = std::min(std::max(hi_raw, 0), n_det - 1);
+    len = hi - lo + 1;
+    return lo_raw >= 0 && hi_raw <= n_det - 1;
+}
+
+/**
+ * Fractional bits of the fixed-point detector coordinates (Q15.16)
+ */
+constexpr int BACKPROJECT_FRAC_BITS = 16;
+
+/**
+ * Backprojection row segment with fixed-point coordinates and no bounds
+ *
+ * Like BackprojectKernel, but u(x) = u_start + x * inc is in Q15.16 relative
+ * to sino_rows[b][0] and the caller guarantees that both taps of every
+ * pixel lie inside the rows (interior tiles of a GeometryOperator). Pixel x
+ * reads taps i = u >> 16 and i + 1 with weight (u & 0xffff) / 65536, so
+ * there are no masks, and integer stepping makes every index independent
+ * of the previous pixel.
+ */
+using BackprojectFixedKernel = void (*)(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc);
+
+/**
+ * Scalar remainder of the fixed-point kernels: pixels [x, n)
+ */
+static inline void backproject_fixed_tail(const float* const* sino_rows,
+    float* const* recon_rows, int S, int x, int n, int32_t u_start, int32_t inc) {
+    constexpr int32_t FRAC_MASK = (1 << BACKPROJECT_FRAC_BITS) - 1;
+    constexpr float FRAC_SCALE = 1.0f / (1 << BACKPROJECT_FRAC_BITS);
+    for (; x < n; ++x) {
+        const int32_t u = u_start + x * inc;
+        const int i = u >> BACKPROJECT_FRAC_BITS;
+        const float du = float(u & FRAC_MASK) * FRAC_SCALE;
+        for (int b = 0; b < S; ++b) {
+            const float v0 = sino_rows[b][i];
+            recon_rows[b][x] += v0 + (sino_rows[b][i + 1] - v0) * du;
+        }
+    }
+}
+
+void backproject_segment_scalar(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset);
+void backproject_fixed_scalar(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc);
+
+#if defined(CT_HAVE_NEON)
+void backproject_segment_neon(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset);
+void backproject_fixed_neon(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc);
+#endif
+
+#if defined(CT_HAVE_AVX2)
+void backproject_segment_avx2(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset);
+void backproject_fixed_avx2(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc);
+#endif
+
+#if defined(CT_HAVE_AVX512)
+void backproject_segment_avx512(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset);
+void backproject_fixed_avx512(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc);
+#endif
+
+/**
+ * Forward projection row segment, the exact adjoint of the kernels above
+ *
+ * Scatters S image row segments into S detector rows of one angle with the
+ * same coordinates, truncation, 8-pixel u blocks and zeroed out-of-range
+ * taps as the backprojection kernels, so <A x, p> == <x, B p> to float
+ * rounding. Scalar only: neighbouring pixels hit the same detector bins,
+ * which rules out conflict-free SIMD scatters.
+ *
+ * @param recon_rows  S image row segments [n]
+ * @param sino_rows   S detector rows [n_det] - accumulated into
+ */
+void forward_segment_scalar(const float* const* recon_rows, float* const* sino_rows,
+    int S, int n, double u_start, double inc, int n_det);
+
+/**
+ * Whether a backend was compiled in and is supported by the running CPU
+ */
+bool backend_available(Backend backend);
+
+/**
+ * Kernel for a resolved (non-Auto) backend
+ */
+BackprojectKernel backproject_kernel(Backend backend);
+
+/**
+ * Fixed-point interior kernel for a resolved (non-Auto) backend
+ */
+BackprojectFixedKernel backproject_fixed_kernel(Backend backend);
@@ -0,0 +1,90 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <immintrin.h>
+
+#include "backproject.h"
+
+// 本文件单独以 -mavx2 -mfma 编译，只在运行时检测到 AVX2 后才会被调用
+void backproject_segment_avx2(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset) {
+    const __m256i zero_i = _mm256_setzero_si256();
+    const __m256i one_i = _mm256_set1_epi32(1);
+    const __m256i max_idx = _mm256_set1_epi32(n_det - 1);
+    const __m256i offset = _mm256_set1_epi32(det_offset);
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    const __m256i n_det_i = _mm256_set1_epi32(n_det);
+    const __m256 one_f = _mm256_set1_ps(1.0f);
+    const __m256d inc_d = _mm256_set1_pd(inc);
+    const __m256d lane_lo = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d lane_hi = _mm256_set_pd(7.0, 6.0, 5.0, 4.0);
+
+    double last_u = u_start;
+
+    int x = 0;
+    for (; x + 7 < n; x += 8) {
+        // u 在 double 里算好再转 float
+        __m256d base = _mm256_set1_pd(last_u);
+        __m128 u_lo = _mm256_cvtpd_ps(_mm256_add_pd(base, _mm256_mul_pd(lane_lo, inc_d)));
+        __m128 u_hi = _mm256_cvtpd_ps(_mm256_add_pd(base, _mm256_mul_pd(lane_hi, inc_d)));
+        __m256 u = _mm256_insertf128_ps(_mm256_castps128_ps256(u_lo), u_hi, 1);
+
+        // 向零取整，与 vcvtq_s32_f32 一致
+        __m256i u0 = _mm256_cvttps_epi32(u);
+        __m256 du = _mm256_sub_ps(u, _mm256_cvtepi32_ps(u0));
+        __m256i u1 = _mm256_add_epi32(u0, one_i);
+
+        // 0 <= i < n_det  <=>  i > -1 && n_det > i
+        __m256i in0 = _mm256_and_si256(_mm256_cmpgt_epi32(u0, minus_one), _mm256_cmpgt_epi32(n_det_i, u0));
+        __m256i in1 = _mm256_and_si256(_mm256_cmpgt_epi32(u1, minus_one), _mm256_cmpgt_epi32(n_det_i, u1));
+        __m256 w0 = _mm256_and_ps(_mm256_castsi256_ps(in0), _mm256_sub_ps(one_f, du));
+        __m256 w1 = _mm256_and_ps(_mm256_castsi256_ps(in1), du);
+
+        __m256i i0 = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(u0, zero_i), max_idx), offset);
+        __m256i i1 = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(u1, zero_i), max_idx), offset);
+
+        for (int b = 0; b < S; ++b) {
+            const float* __restrict sino_row = sino_rows[b];
+            float* __restrict recon_row = recon_rows[b] + x;
+
+            // vpgatherdd：一条指令取 8 个探测器值
+            __m256 s0 = _mm256_i32gather_ps(sino_row, i0, 4);
+            __m256 s1 = _mm256_i32gather_ps(sino_row, i1, 4);
+            __m256 r = _mm256_fmadd_ps(s1, w1, _mm256_mul_ps(s0, w0));
+            _mm256_storeu_ps(recon_row, _mm256_add_ps(_mm256_loadu_ps(recon_row), r));
+        }
+
+        last_u += inc * 8;
+    }
+
+    backproject_segment_tail(sino_rows, recon_rows, S, x, n, last_u, inc, n_det, det_offset);
+}
+
+// 内部 tile 的定点核：坐标全程是 32 位整数，没有越界掩码
+void backproject_fixed_avx2(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc) {
+    const __m256i one_i = _mm256_set1_epi32(1);
+    const __m256i frac_mask = _mm256_set1_epi32((1 << BACKPROJECT_FRAC_BITS) - 1);
+    const __m256 frac_scale = _mm256_set1_ps(1.0f / (1 << BACKPROJECT_FRAC_BITS));
+    const __m256i step = _mm256_set1_epi32(inc * 8);
+    __m256i u = _mm256_add_epi32(_mm256_set1_epi32(u_start),
+        _mm256_mullo_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(inc)));
+
+    int x = 0;
+    for (; x + 7 < n; x += 8) {
+        const __m256i i0 = _mm256_srai_epi32(u, BACKPROJECT_FRAC_BITS);
+        const __m256i i1 = _mm256_add_epi32(i0, one_i);
+        const __m256 du = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(u, frac_mask)), frac_scale);
+        for (int b = 0; b < S; ++b) {
+            const float* sino_row = sino_rows[b];
+            float* recon_row = recon_rows[b] + x;
+            __m256 s0 = _mm256_i32gather_ps(sino_row, i0, 4);
+            __m256 s1 = _mm256_i32gather_ps(sino_row, i1, 4);
+            __m256 r = _mm256_fmadd_ps(_mm256_sub_ps(s1, s0), du, s0);
+            _mm256_storeu_ps(recon_row, _mm256_add_ps(_mm256_loadu_ps(recon_row), r));
+        }
+        u = _mm256_add_epi32(u, step);
+    }
+
+    backproject_fixed_tail(sino_rows, recon_rows, S, x, n, u_start, inc);
+}
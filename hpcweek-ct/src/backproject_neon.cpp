@@ -0,0 +1,91 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <arm_neon.h>
+
+#include "backproject.h"
+
+void backproject_segment_neon(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset) {
+    // 预先创建常量（避免每次循环重复创建）
+    const int32x4_t zero_vec = vdupq_n_s32(0);
+    const int32x4_t n_det_vec = vdupq_n_s32(n_det);
+    const int32x4_t max_idx_vec = vdupq_n_s32(n_det - 1);
+    const int32x4_t one_s32 = vdupq_n_s32(1);
+    const int32x4_t offset_vec = vdupq_n_s32(det_offset);
+    const float32x4_t zero_f = vdupq_n_f32(0.0f);
+    const float32x4_t one_f = vdupq_n_f32(1.0f);
+
+    double last_u = u_start;
+
+    int x = 0;
+    // 向量化处理，每次处理8个元素
+    for (; x + 7 < n; x += 8) {
+        // 计算8个u值: last_u, last_u+inc, ..., last_u+7*inc
+        // 必须在 double 里相加后再转 float，先转 float 再相加会导致部分测试数据出错
+        float32x4_t u_vec_lo = {static_cast<float>(last_u), static_cast<float>(last_u+inc), static_cast<float>(last_u+2*inc), static_cast<float>(last_u+3*inc)};
+        float32x4_t u_vec_hi = {static_cast<float>(last_u+4*inc), static_cast<float>(last_u+5*inc), static_cast<float>(last_u+6*inc), static_cast<float>(last_u+7*inc)};
+
+        // 计算整数部分 u0 (向零取整)
+        int32x4_t u0_lo = vcvtq_s32_f32(u_vec_lo);
+        int32x4_t u0_hi = vcvtq_s32_f32(u_vec_hi);
+
+        // 计算小数部分 du = u - u0
+        float32x4_t du_lo = vsubq_f32(u_vec_lo, vcvtq_f32_s32(u0_lo));
+        float32x4_t du_hi = vsubq_f32(u_vec_hi, vcvtq_f32_s32(u0_hi));
+
+        // 计算 u1 = u0 + 1
+        int32x4_t u1_lo = vaddq_s32(u0_lo, one_s32);
+        int32x4_t u1_hi = vaddq_s32(u0_hi, one_s32);
+
+        // 边界检查：越界的一侧权重置 0（对整个 batch 只做一次）
+        uint32x4_t mask0_lo = vandq_u32(vcgeq_s32(u0_lo, zero_vec), vcltq_s32(u0_lo, n_det_vec));
+        uint32x4_t mask1_lo = vandq_u32(vcgeq_s32(u1_lo, zero_vec), vcltq_s32(u1_lo, n_det_vec));
+        uint32x4_t mask0_hi = vandq_u32(vcgeq_s32(u0_hi, zero_vec), vcltq_s32(u0_hi, n_det_vec));
+        uint32x4_t mask1_hi = vandq_u32(vcgeq_s32(u1_hi, zero_vec), vcltq_s32(u1_hi, n_det_vec));
+
+        float32x4_t w0_lo = vbslq_f32(mask0_lo, vsubq_f32(one_f, du_lo), zero_f);
+        float32x4_t w1_lo = vbslq_f32(mask1_lo, du_lo, zero_f);
+        float32x4_t w0_hi = vbslq_f32(mask0_hi, vsubq_f32(one_f, du_hi), zero_f);
+        float32x4_t w1_hi = vbslq_f32(mask1_hi, du_hi, zero_f);
+
+        // 下标夹到 [0, n_det-1]：权重已为 0，读到的值不影响结果
+        int u0_arr[8], u1_arr[8];
+        vst1q_s32(u0_arr,     vsubq_s32(vminq_s32(vmaxq_s32(u0_lo, zero_vec), max_idx_vec), offset_vec));
+        vst1q_s32(u0_arr + 4, vsubq_s32(vminq_s32(vmaxq_s32(u0_hi, zero_vec), max_idx_vec), offset_vec));
+        vst1q_s32(u1_arr,     vsubq_s32(vminq_s32(vmaxq_s32(u1_lo, zero_vec), max_idx_vec), offset_vec));
+        vst1q_s32(u1_arr + 4, vsubq_s32(vminq_s32(vmaxq_s32(u1_hi, zero_vec), max_idx_vec), offset_vec));
+
+        for (int b = 0; b < S; ++b) {
+            const float* __restrict sino_row = sino_rows[b];
+            float* __restrict recon_row = recon_rows[b];
+
+            // NEON 没有 gather 指令，只能逐个标量加载
+            float sino0_data[8], sino1_data[8];
+            for (int k = 0; k < 8; ++k) {
+                sino0_data[k] = sino_row[u0_arr[k]];
+                sino1_data[k] = sino_row[u1_arr[k]];
+            }
+
+            // result = sino0 * w0 + sino1 * w1
+            float32x4_t result_lo = vmlaq_f32(vmulq_f32(vld1q_f32(sino0_data), w0_lo), vld1q_f32(sino1_data), w1_lo);
+            float32x4_t result_hi = vmlaq_f32(vmulq_f32(vld1q_f32(sino0_data + 4), w0_hi), vld1q_f32(sino1_data + 4), w1_hi);
+
+            // 加载当前recon_row的值并累加
+            vst1q_f32(recon_row + x,     vaddq_f32(vld1q_f32(recon_row + x), result_lo));
+            vst1q_f32(recon_row + x + 4, vaddq_f32(vld1q_f32(recon_row + x + 4), result_hi));
+        }
+
+        // 更新last_u
+        last_u += inc * 8;
+    }
+
+    // 处理剩余的元素
+    backproject_segment_tail(sino_rows, recon_rows, S, x, n, last_u, inc, n_det, det_offset);
+}
+
+// 内部 tile 的定点核：NEON 没有 gather，逐像素取数
+void backproject_fixed_neon(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc) {
+    backproject_fixed_tail(sino_rows, recon_rows, S, 0, n, u_start, inc);
+}
@@ -0,0 +1,99 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include "backproject.h"
+
+/**
+ * Portable reference kernel, builds on any host
+ *
+ * Follows the SIMD kernels step by step (8-pixel blocks, float u, clamped
+ * indices with zeroed weights) so it can be used to validate them.
+ */
+void backproject_segment_scalar(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, double u_start, double inc, int n_det,
+    int det_offset) {
+    double last_u = u_start;
+
+    int x = 0;
+    for (; x + 7 < n; x += 8) {
+        int u0_arr[8], u1_arr[8];
+        float w0[8], w1[8];
+        for (int k = 0; k < 8; ++k) {
+            // double 里相加后再转 float
+            float u = static_cast<float>(last_u + k * inc);
+            int u0 = int(u);
+            float du = u - float(u0);
+            int u1 = u0 + 1;
+            w0[k] = (u0 >= 0 && u0 < n_det) ? 1.0f - du : 0.0f;
+            w1[k] = (u1 >= 0 && u1 < n_det) ? du : 0.0f;
+            u0_arr[k] = std::min(std::max(u0, 0), n_det - 1) - det_offset;
+            u1_arr[k] = std::min(std::max(u1, 0), n_det - 1) - det_offset;
+        }
+        for (int b = 0; b < S; ++b) {
+            const float* __restrict sino_row = sino_rows[b];
+            float* __restrict recon_row = recon_rows[b] + x;
+            for (int k = 0; k < 8; ++k) {
+                recon_row[k] += sino_row[u0_arr[k]] * w0[k] + sino_row[u1_arr[k]] * w1[k];
+            }
+        }
+        last_u += inc * 8;
+    }
+
+    backproject_segment_tail(sino_rows, recon_rows, S, x, n, last_u, inc, n_det, det_offset);
+}
+
+// 内部 tile 的定点核（可移植版本）
+void backproject_fixed_scalar(const float* const* sino_rows,
+    float* const* recon_rows, int S, int n, int32_t u_start, int32_t inc) {
+    backproject_fixed_tail(sino_rows, recon_rows, S, 0, n, u_start, inc);
+}
+
+void forward_segment_scalar(const float* const* recon_rows, float* const* sino_rows,
+    int S, int n, double u_start, double inc, int n_det) {
+    double last_u = u_start;
+
+    // 坐标计算与 backproject_segment_scalar 逐步一致（8 像素一组，组内 double 相加后转 float）
+    int x = 0;
+    for (; x + 7 < n; x += 8) {
+        int u0_arr[8], u1_arr[8];
+        float w0[8], w1[8];
+        for (int k = 0; k < 8; ++k) {
+            float u = static_cast<float>(last_u + k * inc);
+            int u0 = int(u);
+            float du = u - float(u0);
+            int u1 = u0 + 1;
+            w0[k] = (u0 >= 0 && u0 < n_det) ? 1.0f - du : 0.0f;
+            w1[k] = (u1 >= 0 && u1 < n_det) ? du : 0.0f;
+            u0_arr[k] = std::min(std::max(u0, 0), n_det - 1);
+            u1_arr[k] = std::min(std::max(u1, 0), n_det - 1);
+        }
+        for (int b = 0; b < S; ++b) {
+            const float* __restrict recon_row = recon_rows[b] + x;
+            float* __restrict sino_row = sino_rows[b];
+            for (int k = 0; k < 8; ++k) {
+                sino_row[u0_arr[k]] += recon_row[k] * w0[k];
+                sino_row[u1_arr[k]] += recon_row[k] * w1[k];
+            }
+        }
+        last_u += inc * 8;
+    }
+
+    // 余下像素与 backproject_segment_tail 一致：u 保持 double
+    for (; x < n; ++x) {
+        double u = last_u;
+        last_u = u + inc;
+
+        int u0 = int(u);
+        float du = u - u0;
+        int u1 = u0 + 1;
+
+        float w0 = (u0 >= 0 && u0 < n_det) ? 1.0f - du : 0.0f;
+        float w1 = (u1 >= 0 && u1 < n_det) ? du : 0.0f;
+        u0 = std::min(std::max(u0, 0), n_det - 1);
+        u1 = std::min(std::max(u1, 0), n_det - 1);
+
+        for (int b = 0; b < S; ++b) {
+            sino_rows[b][u0] += recon_rows[b][x] * w0;
+            sino_rows[b][u1] += recon_rows[b][x] * w1;
+        }
+    }
+}
@@ -5,88 +5,618 @@
 #include <vector>
 #include <bits/stdc++.h>
 #include <omp.h>
-#include <arm_neon.h>
 
+#include "angle_weights.h"
+#include "backproject.h"
 #include "fbp.h"
+#include "geometry_cache.h"
+#include "profiler.h"
+#include "ramp_filter.h"
+#include "sino_codec.h"
 
 constexpr double PI = 3.14159265358979323846;
 
+FilterType parse_filter_type(const std::string& name) {
+    if (name == "ram-lak" || name == "ramlak") return FilterType::RamLak;
+    if (name == "shepp-logan")                 return FilterType::SheppLogan;
+    if (name == "cosine")                      return FilterType::Cosine;
+    if (name == "hamming")                     return FilterType::Hamming;
+    if (name == "hann")                        return FilterType::Hann;
+    throw std::invalid_argument("Unknown filter: " + name);
+}
+
+const char* filter_type_name(FilterType type) {
+    switch (type) {
+        case FilterType::RamLak:     return "ram-lak";
+        case FilterType::SheppLogan: return "shepp-logan";
+        case FilterType::Cosine:     return "cosine";
+        case FilterType::Hamming:    return "hamming";
+        case FilterType::Hann:       return "hann";
+    }
+    return "unknown";
+}
+
+ReconGrid ReconGrid::roi(int x, int y, int w, int h, double pixel) {
+    if (w < 1 || h < 1 || !(pixel > 0)) throw std::invalid_argument("ROI needs a positive size and pixel size");
+    ReconGrid grid;
+    grid.nx = int(std::ceil(w / pixel - 1e-9));
+    grid.ny = int(std::ceil(h / pixel - 1e-9));
+    // ROI 覆盖 [x - 0.5, x + w - 0.5]，第一个像素中心在其左上角内半个像素处
+    grid.x0 = x - 0.5 + 0.5 * pixel;
+    grid.y0 = y - 0.5 + 0.5 * pixel;
+    grid.pixel = pixel;
+    return grid;
+}
+
+ReconGrid ReconGrid::resolved(int n_det) const {
+    ReconGrid grid = *this;
+    if (grid.nx <= 0) grid.nx = n_det;
+    if (grid.ny <= 0) grid.ny = n_det;
+    return grid;
+}
+
+/**
+ * Maximum number of slices sharing one set of interpolation coordinates
+ */
+constexpr int MAX_SLICE_BATCH = 16;
+
+/**
+ * Backproject all angles of S slices into image row y (accumulating)
+ *
+ * The geometry is identical across slices, so the kernel computes u0/u1/du
+ * and the bounds masks once per (angle, pixel block) and applies them to S
+ * sinogram rows, amortizing the coordinate arithmetic over the batch.
+ *
+ * Loop order inside a row is angle -> x so that the recon rows stay in L1
+ * and the x loop is contiguous for SIMD.
+ *
+ * @param sino_slices  S filtered sinograms, each [n_angles, n_det]
+ * @param recon_rows   S output rows, each [grid.nx] - accumulated into
+ * @param S            Batch size (1..MAX_SLICE_BATCH)
+ * @param y            Output row index
+ * @param geo          Geometry
+ * @param grid         Resolved output grid
+ * @param kernel       Backend row-segment kernel
+ */
+static void backproject_row_batch(const float* const* sino_slices,
+    float* const* recon_rows, int S, int y, const Geometry& geo,
+    const ReconGrid& grid, BackprojectKernel kernel) {
+    const int n_angles = geo.n_angles;
+    const int n_det = geo.n_det;
+    const double yr = grid.y0 + y * grid.pixel - geo.cy;  // Y coordinate relative to image center
+    const double xr = grid.x0 - geo.cx;                  // 第一个像素的 X 坐标
+
+    const float* sino_rows[MAX_SLICE_BATCH];
+    for (int ai = 0; ai < n_angles; ++ai) {
+        const double c = geo.cos_t[ai];
+        const double s = geo.sin_t[ai];
+        const size_t row_off = size_t(ai) * n_det;
+        for (int b = 0; b < S; ++b) sino_rows[b] = sino_slices[b] + row_off;
+
+        double u_start = xr * c + yr * s + geo.t_half;
+        kernel(sino_rows, recon_rows, S, grid.nx, u_start, grid.pixel * c, n_det, 0);
+    }
+}
+
+/**
+ * Backproject image rows [y_begin, y_end) of S consecutive slices
+ *
+ * @param sino_batch   First filtered sinogram of the batch [S, n_angles, n_det]
+ * @param recon_batch  First output image of the batch [S, grid.ny, grid.nx]
+ * @param S            Batch size (1..MAX_SLICE_BATCH)
+ */
+static void backproject_rows(const float* __restrict sino_batch,
+    float* __restrict recon_batch, int S, int y_begin, int y_end,
+    const Geometry& geo, const ReconGrid& grid, BackprojectKernel kernel) {
+    const int nx = grid.nx;
+    const size_t slice_size = size_t(geo.n_angles) * geo.n_det;
+    const size_t recon_size = size_t(nx) * grid.ny;
+
+    const float* sino_slices[MAX_SLICE_BATCH];
+    float* recon_rows[MAX_SLICE_BATCH];
+    for (int b = 0; b < S; ++b) sino_slices[b] = sino_batch + b * slice_size;
+
+    for (int y = y_begin; y < y_end; ++y) {
+        for (int b = 0; b < S; ++b) recon_rows[b] = recon_batch + b * recon_size + size_t(y) * nx;
+        ProfileScope timer(Stage::Backproject, true);
+        backproject_row_batch(sino_slices, recon_rows, S, y, geo, grid, kernel);
+    }
+}
+
+/**
+ * Backprojection plan shared by all work units of one reconstruction
+ *
+ * A work unit is one image tile of a slice batch. In row mode (tile == 0)
+ * a unit is a full image row and every angle reads its whole detector row.
+ * In tile mode a unit is a tile x tile pixel square; angles are processed in
+ * blocks, and for each block only the detector span hit by the tile's
+ * footprint is copied into a small contiguous per-thread buffer.
+ */
+struct BackprojectPlan {
+    const Geometry* geo;
+    ReconGrid grid;              // Resolved output grid
+    const GeometryOperator* op;  // nullptr: spans and coordinates on the fly (tile mode)
+    BackprojectKernel kernel;
+    BackprojectFixedKernel fixed_kernel;  // Interior tiles of op
+    float scale;                 // Left to apply after accumulation (1 if folded into the filter)
+    int tile;                    // Tile edge in pixels, 0 = row mode
+    int angle_block;             // Angles per span buffer (tile mode)
+    SinoPrecision precision;     // F32: read the float sinogram, else the packed batch
+    const QuantizedOutput* quant;  // Fused quantization epilogue, nullptr if off
+    int tiles_x, tiles_y;
+
+    int n_units() const { return tiles_x * tiles_y; }
+};
+
+/**
+ * Per-thread scratch of the tiled backprojector
+ */
+struct TileScratch {
+    std::vector<float> span;           // [angle_block, S, span_len] detector spans
+    std::vector<int> lo, off, len;     // Per angle of the block: first index, buffer offset, length
+    double sino_bytes = 0;             // Sinogram bytes loaded (for the benchmark)
+};
+
+/**
+ * Filtered sinogram batch in 16-bit storage
+ */
+struct PackedBatch {
+    std::vector<uint16_t> data;  // [S, n_angles, n_det] encoded samples
+    std::vector<float> scale;    // [S, n_angles] per detector row
+};
+
+/**
+ * Encode detector rows [r0, r1) of a filtered batch into packed
+ */
+static void pack_rows(const float* __restrict sino_batch, int r0, int r1, int n_det,
+    SinoPrecision precision, PackedBatch& packed) {
+    for (int r = r0; r < r1; ++r) {
+        const size_t off = size_t(r) * n_det;
+        packed.scale[r] = encode_sino_row(sino_batch + off, n_det, precision, packed.data.data() + off);
+    }
+}
+
 /**
- * Generate Ramp filter kernel in spatial domain
- * 
- * @param len  Kernel length (will be made odd if even)
- * @param d    Detector pixel spacing (default 1.0)
- * @return     Symmetric filter kernel centered at middle
+ * Backproject one pixel tile of S slices over all angles
+ *
+ * @param packed  Encoded copy of the batch to read instead of sino_batch
+ *                (plan.precision != F32), nullptr otherwise
  */
-static std::vector<float> ramp_kernel(int len, float d = 1.0f) {
-    if (len % 2 == 0) len += 1;  // Ensure odd length for symmetry
-    int K = len / 2;  // Center index
-    
-    std::vector<float> h(len, 0.0f);
-    
-    // Center value
-    h[K] = 1.0f / (4.0f * d * d);
-    
-    // Symmetric side lobes (only odd positions have non-zero values)
-    for (int n = 1; n <= K; ++n) {
-        if (n % 2 == 1) {
-            float val = -1.0f / (float(PI) * float(PI) * n * n * d * d);
-            h[K + n] = val;
-            h[K - n] = val;
+static void backproject_tile(const float* __restrict sino_batch,
+    const PackedBatch* packed, float* __restrict recon_batch, int S, int unit,
+    const BackprojectPlan& plan, TileScratch& scratch) {
+    const Geometry& geo = *plan.geo;
+    const ReconGrid& grid = plan.grid;
+    const int n_angles = geo.n_angles;
+    const int n_det = geo.n_det;
+    const int nx = grid.nx;
+    const size_t slice_size = size_t(n_angles) * n_det;
+    const size_t recon_size = size_t(nx) * grid.ny;
+    const int T = plan.tile;
+    const int A = plan.angle_block;
+
+    const int y0 = (unit / plan.tiles_x) * T, y1 = std::min(grid.ny, y0 + T);
+    const int x0 = (unit % plan.tiles_x) * T, x1 = std::min(nx, x0 + T);
+    const int tw = x1 - x0;
+    const GeometryOperator::Span* spans = plan.op ? plan.op->tile_spans(unit) : nullptr;
+    // tile 四角相对旋转中心的坐标
+    const double xa = grid.x0 + x0 * grid.pixel - geo.cx, xb = grid.x0 + (x1 - 1) * grid.pixel - geo.cx;
+    const double ya = grid.y0 + y0 * grid.pixel - geo.cy, yb = grid.y0 + (y1 - 1) * grid.pixel - geo.cy;
+
+    scratch.span.resize(size_t(A) * S * n_det);
+    scratch.lo.resize(A);
+    scratch.off.resize(A);
+    scratch.len.resize(A);
+
+    const float* sino_rows[MAX_SLICE_BATCH];
+    float* recon_rows[MAX_SLICE_BATCH];
+
+    ProfileScope timer(Stage::Backproject, true);
+    for (int a0 = 0; a0 < n_angles; a0 += A) {
+        const int a1 = std::min(n_angles, a0 + A);
+
+        // 1) 把 tile 足迹覆盖的探测器区间拷进连续缓冲区
+        size_t pos = 0;
+        for (int ai = a0; ai < a1; ++ai) {
+            int lo, len;
+            if (spans) {
+                lo = spans[ai].lo;
+                len = spans[ai].len;
+            } else {
+                detector_span(xa, xb, ya, yb, geo.cos_t[ai], geo.sin_t[ai], geo.t_half, n_det, lo, len);
+            }
+
+            const int k = ai - a0;
+            scratch.lo[k] = lo;
+            scratch.off[k] = int(pos);
+            scratch.len[k] = len;
+            for (int b = 0; b < S; ++b) {
+                float* dst = scratch.span.data() + pos + size_t(b) * len;
+                if (packed) {
+                    // 16 位样本在这里解码成 float，kernel 与 FP32 路径完全相同
+                    const size_t r = size_t(b) * n_angles + ai;
+                    decode_sino_row(packed->data.data() + r * n_det + lo, len, packed->scale[r],
+                                    plan.precision, dst);
+                } else {
+                    const float* src = sino_batch + b * slice_size + size_t(ai) * n_det + lo;
+                    std::copy(src, src + len, dst);
+                }
+            }
+            pos += size_t(S) * len;
+        }
+        scratch.sino_bytes += packed ? double(pos) * sizeof(uint16_t) + double(a1 - a0) * S * sizeof(float)
+                                     : double(pos) * sizeof(float);
+
+        // 2) 对 tile 内每一行累加这一块角度
+        for (int y = y0; y < y1; ++y) {
+            const double yr = grid.y0 + y * grid.pixel - geo.cy;
+            for (int b = 0; b < S; ++b) recon_rows[b] = recon_batch + b * recon_size + size_t(y) * nx + x0;
+            for (int ai = a0; ai < a1; ++ai) {
+                const int k = ai - a0;
+                const double c = geo.cos_t[ai];
+                const double s = geo.sin_t[ai];
+                for (int b = 0; b < S; ++b) {
+                    sino_rows[b] = scratch.span.data() + scratch.off[k] + size_t(b) * scratch.len[k];
+                }
+                if (spans && spans[ai].u0 >= 0) {
+                    // 内部 tile：定点起点 + 整数步进，无越界掩码
+                    const int32_t u_start = spans[ai].u0 + (y - y0) * plan.op->du_dy[ai];
+                    plan.fixed_kernel(sino_rows, recon_rows, S, tw, u_start, plan.op->du_dx[ai]);
+                    continue;
+                }
+                double u_start = xa * c + yr * s + geo.t_half;
+                plan.kernel(sino_rows, recon_rows, S, tw, u_start, grid.pixel * c, n_det, scratch.lo[k]);
+            }
+        }
+    }
+
+}
+
+/**
+ * Per-unit min / max of each slice of a batch, for the fused epilogue
+ */
+struct UnitRanges {
+    std::vector<float> lo, hi;  // [S, n_units]
+    float slice_lo[MAX_SLICE_BATCH], slice_hi[MAX_SLICE_BATCH];
+};
+
+/**
+ * Quantize pixels to [0, max_value] exactly like normalize_slice_u8
+ */
+template <typename T>
+static void quantize_row(const float* __restrict src, int n, float lo, float den, float max_value,
+    T* __restrict dst) {
+    #pragma omp simd
+    for (int x = 0; x < n; ++x) {
+        float v = (src[x] - lo) / den * max_value + 0.5f;
+        dst[x] = T(std::min(max_value, std::max(0.0f, v)));
+    }
+}
+
+/**
+ * Quantize image row y of output slice `slice` into the fused output
+ * (bottom-up rows like the PNG writer)
+ */
+static void quantize_output_row(const float* recon_row, int slice, int y, int x0, int n,
+    float lo, float hi, const BackprojectPlan& plan) {
+    const QuantizedOutput& q = *plan.quant;
+    const size_t off = (size_t(slice) * plan.grid.ny + (plan.grid.ny - 1 - y)) * plan.grid.nx + x0;
+    const float den = (hi > lo) ? (hi - lo) : 1.0f;
+    if (q.bits == 16) {
+        quantize_row(recon_row, n, lo, den, 65535.0f, static_cast<uint16_t*>(q.data) + off);
+    } else {
+        quantize_row(recon_row, n, lo, den, 255.0f, static_cast<uint8_t*>(q.data) + off);
+    }
+}
+
+/**
+ * Epilogue of one work unit while its pixels are still in cache: apply
+ * what is left of the scale (only without filter), record the unit's
+ * min / max and, with a fixed window, write the quantized pixels
+ *
+ * @param s0  Index of the batch's first slice in the volume
+ */
+static void finish_unit(float* __restrict recon_batch, int S, int s0, int unit,
+    const BackprojectPlan& plan, UnitRanges* ranges) {
+    const bool scale = plan.scale != 1.0f;
+    if (!scale && !plan.quant) return;
+    ProfileScope timer(Stage::Scale);
+
+    const ReconGrid& grid = plan.grid;
+    const size_t recon_size = size_t(grid.nx) * grid.ny;
+    int y0 = unit, y1 = unit + 1, x0 = 0, x1 = grid.nx;
+    if (plan.tile > 0) {
+        y0 = (unit / plan.tiles_x) * plan.tile;
+        y1 = std::min(grid.ny, y0 + plan.tile);
+        x0 = (unit % plan.tiles_x) * plan.tile;
+        x1 = std::min(grid.nx, x0 + plan.tile);
+    }
+    const int tw = x1 - x0;
+
+    for (int b = 0; b < S; ++b) {
+        float lo = INFINITY, hi = -INFINITY;
+        for (int y = y0; y < y1; ++y) {
+            float* __restrict recon_row = recon_batch + b * recon_size + size_t(y) * grid.nx + x0;
+            if (scale) {
+                #pragma omp simd
+                for (int x = 0; x < tw; ++x) recon_row[x] *= plan.scale;
+            }
+            if (!plan.quant) continue;
+            #pragma omp simd reduction(min:lo) reduction(max:hi)
+            for (int x = 0; x < tw; ++x) {
+                lo = std::min(lo, recon_row[x]);
+                hi = std::max(hi, recon_row[x]);
+            }
+            if (plan.quant->fixed_window) {
+                quantize_output_row(recon_row, s0 + b, y, x0, tw, plan.quant->lo, plan.quant->hi, plan);
+            }
+        }
+        if (ranges) {
+            ranges->lo[size_t(b) * plan.n_units() + unit] = lo;
+            ranges->hi[size_t(b) * plan.n_units() + unit] = hi;
         }
     }
-    
-    return h;
 }
 
 /**
- * Apply Ramp filter to all projections in a sinogram (in-place convolution)
- * 
- * For each projection angle, convolve detector readings with ramp kernel.
- * This enhances high frequencies and suppresses low frequencies to prevent blurring.
- * 
- * @param sino     Sinogram data [n_angles, n_det] - modified in-place
- * @param n_angles Number of projection angles
- * @param n_det    Number of detector pixels
- * @param kernel   Ramp filter kernel
+ * Reduce the unit ranges of a finished batch to per-slice min / max and
+ * report them
  */
-static void filter_projections(float* __restrict sino,
-    int n_angles, int n_det,
-    const std::vector<float>& kernel) {
-    const int K = int(kernel.size() / 2);
-    const float* __restrict k_data = kernel.data();  // 优化：缓存指针
-
-    // 并行化外层循环（角度循环）- 每个线程处理一个角度
-    #pragma omp parallel
+static void reduce_ranges(UnitRanges& ranges, int S, int s0, const BackprojectPlan& plan) {
+    const int n_units = plan.n_units();
+    for (int b = 0; b < S; ++b) {
+        const float* lo = ranges.lo.data() + size_t(b) * n_units;
+        const float* hi = ranges.hi.data() + size_t(b) * n_units;
+        ranges.slice_lo[b] = *std::min_element(lo, lo + n_units);
+        ranges.slice_hi[b] = *std::max_element(hi, hi + n_units);
+        if (plan.quant->slice_min) plan.quant->slice_min[s0 + b] = ranges.slice_lo[b];
+        if (plan.quant->slice_max) plan.quant->slice_max[s0 + b] = ranges.slice_hi[b];
+    }
+}
+
+/**
+ * Backproject one work unit (image row or tile) of a slice batch and run
+ * its epilogue
+ *
+ * @param s0      Index of the batch's first slice in the volume
+ * @param ranges  Unit min / max of the batch (fused epilogue), or nullptr
+ */
+static void backproject_unit(const float* __restrict sino_batch,
+    const PackedBatch* packed, float* __restrict recon_batch, int S, int s0, int unit,
+    const BackprojectPlan& plan, TileScratch& scratch, UnitRanges* ranges) {
+    if (plan.tile == 0) {
+        const Geometry& geo = *plan.geo;
+        backproject_rows(sino_batch, recon_batch, S, unit, unit + 1, geo, plan.grid, plan.kernel);
+        scratch.sino_bytes += double(S) * geo.n_angles * geo.n_det * sizeof(float);
+    } else {
+        backproject_tile(sino_batch, packed, recon_batch, S, unit, plan, scratch);
+    }
+    finish_unit(recon_batch, S, s0, unit, plan, ranges);
+}
+
+/**
+ * Shared driver of fbp_reconstruct_3d and fbp_backproject_3d
+ *
+ * @param filter_in_place  Ramp-filter sino_buffer before backprojection
+ * @param sino_bytes       If non-null, receives the sinogram bytes loaded by
+ *                         the backprojector
+ * @param given_weights    Per-angle d_theta to fold into the filtered rows
+ *                         instead of options.angle_weighting (nullptr:
+ *                         weights of options.angle_weighting)
+ * @param quant            Fused quantized output, or nullptr
+ */
+static void run_fbp(float* __restrict sino_buffer, float* __restrict recon_buffer,
+    int n_slices, int n_angles, int n_det, const std::vector<float>& angles_deg,
+    const ReconGrid& out_grid, const FbpOptions& options, bool filter_in_place, double* sino_bytes,
+    const float* given_weights = nullptr, const QuantizedOutput* quant = nullptr) {
+    const ReconGrid grid = out_grid.resolved(n_det);
+    const size_t slice_size = size_t(n_angles) * n_det;
+    const size_t recon_size = size_t(grid.nx) * grid.ny;
+
+    // ==== 采样间距（按你的真实数据设置） ====
+    const double d_det = 1.0;  // 探测器像素间距
+
+    // ---------- 预计算角度 & 几何中心 ----------
+    const Geometry geo = make_geometry(n_angles, n_det, angles_deg);
+    float scale = float(PI) / float(n_angles);  // Normalization factor from Radon inversion
+
+    if (quant && quant->bits != 8 && quant->bits != 16) {
+        throw std::invalid_argument("Quantized output must be 8 or 16 bits");
+    }
+
+    // Ramp 滤波器（频域带窗，核谱每个几何只算一次）
+    std::unique_ptr<RampFilter> filter;
+    if (filter_in_place) filter.reset(new RampFilter(n_det, float(d_det), options.filter));
+
+    // ---------- 反投影计划 ----------
+    BackprojectPlan plan;
+    plan.geo = &geo;
+    plan.grid = grid;
+    plan.op = nullptr;
+    // 运行时选择 SIMD 后端
+    const Backend backend = resolve_backend(options.backend);
+    plan.kernel = backproject_kernel(backend);
+    plan.fixed_kernel = backproject_fixed_kernel(backend);
+    plan.scale = scale;
+    plan.tile = std::max(0, options.tile_size);
+    plan.angle_block = std::max(1, std::min(options.angle_block, n_angles));
+    plan.precision = options.sino_precision;
+    plan.quant = quant;
+    const bool pack = plan.precision != SinoPrecision::F32;
+    if (pack && plan.tile == 0) {
+        throw std::invalid_argument(std::string("Sinogram precision ") + sino_precision_name(plan.precision)
+                                    + " needs the tiled backprojector (tile > 0)");
+    }
+
+    // 可选：几何算子缓存（逐 tile 的探测器区间和定点起点，同一几何的重复重建直接复用）
+    std::shared_ptr<const GeometryOperator> op;
+    // 累加模式每次调用的角度子集都不同，算子无从复用，不建
+    const bool geometry_cache = options.geometry_cache && !given_weights;
+    if (geometry_cache && plan.tile == 0) {
+        std::cerr << "Warning: geometry cache needs the tiled backprojector (tile > 0), "
+                     "computing geometry on the fly\n";
+    } else if (geometry_cache) {
+        op = get_geometry_operator(geo, grid, plan.tile, options.geometry_cache_dir,
+                                   options.geometry_cache_max_mb << 20);
+        plan.op = op.get();
+    }
+
+    // 归一化系数和逐角度 dθ 一起在滤波写回时乘进 sinogram 行，
+    // 反投影累加完就是最终值，不再对输出做缩放扫描
+    std::vector<float> weights;
+    if (filter_in_place && !given_weights) {
+        if (options.angle_weighting == AngleWeighting::Uniform) {
+            weights.assign(n_angles, scale);
+        } else {
+            weights = angle_weights(angles_deg, options.angle_weighting, 180.0);
+        }
+        plan.scale = 1.0f;
+    }
+    if (given_weights) plan.scale = 1.0f;
+    const float* w = given_weights ? given_weights : weights.empty() ? nullptr : weights.data();
+
+    if (plan.tile == 0) {
+        plan.tiles_x = 1;
+        plan.tiles_y = grid.ny;
+    } else {
+        plan.tiles_x = (grid.nx + plan.tile - 1) / plan.tile;
+        plan.tiles_y = (grid.ny + plan.tile - 1) / plan.tile;
+    }
+    const int n_units = plan.n_units();
+
+    // ---------- 单趟流水：每批 slice 滤波后立刻反投影 ----------
+    // 相邻 S 个 slice 组成一批，共享同一套插值坐标。
+    // 批次足够多时，每个线程端到端负责整批：滤波后的 sinogram 还在
+    // L2 里就被反投影读走，整卷数据只过一遍 DRAM，也没有逐 slice 的 fork/join。
+    // 批次少于线程数时，所有线程在同一个并行区内协作处理每一批。
+    const int S = std::max(1, std::min(options.slice_batch, MAX_SLICE_BATCH));
+    const int n_batches = (n_slices + S - 1) / S;
+    const bool batch_parallel = n_batches >= omp_get_max_threads();
+    double total_bytes = 0;
+
+    // 16 位存储：批内各线程协作时共用一份编码缓冲区，否则每个线程一份
+    PackedBatch shared_packed;
+    if (pack && !batch_parallel) {
+        shared_packed.data.resize(size_t(S) * slice_size);
+        shared_packed.scale.resize(size_t(S) * n_angles);
+    }
+
+    // 融合尾处理：各 unit 的 min/max 同样按线程或按批共享
+    const bool auto_window = quant && !quant->fixed_window;
+    UnitRanges shared_ranges;
+    if (quant && !batch_parallel) {
+        shared_ranges.lo.resize(size_t(S) * n_units);
+        shared_ranges.hi.resize(size_t(S) * n_units);
+    }
+
+    #pragma omp parallel reduction(+:total_bytes)
     {
-        // 每个线程有自己的临时缓冲区，避免数据竞争
-        std::vector<float> tmp(n_det);
-        float* __restrict tmp_data = tmp.data();
-
-        #pragma omp for schedule(static)
-        for (int a = 0; a < n_angles; ++a) {
-            float* __restrict row = sino + a * n_det;
-            
-            // 1D 卷积：计算每个检测器位置的滤波值
-            for (int x = 0; x < n_det; ++x) {
-                int k_start = std::max(-K, -x);
-                int k_end   = std::min( K, n_det - 1 - x);
-
-                double acc = 0.0f;
-
-                for (int k = k_start; k <= k_end; ++k) {
-                    acc += row[x + k] * k_data[K + k];
+        // 每个线程有自己的 FFT 缓冲区和 span 缓冲区，避免数据竞争
+        std::vector<std::complex<float>> work(filter ? filter->n_fft : 0);
+        TileScratch scratch;
+        PackedBatch thread_packed;
+        PackedBatch* packed = nullptr;
+        if (pack && batch_parallel) {
+            thread_packed.data.resize(size_t(S) * slice_size);
+            thread_packed.scale.resize(size_t(S) * n_angles);
+            packed = &thread_packed;
+        } else if (pack) {
+            packed = &shared_packed;
+        }
+        UnitRanges thread_ranges;
+        UnitRanges* ranges = nullptr;
+        if (quant && batch_parallel) {
+            thread_ranges.lo.resize(size_t(S) * n_units);
+            thread_ranges.hi.resize(size_t(S) * n_units);
+            ranges = &thread_ranges;
+        } else if (quant) {
+            ranges = &shared_ranges;
+        }
+
+        if (batch_parallel) {
+            #pragma omp for schedule(dynamic, 1)
+            for (int batch = 0; batch < n_batches; ++batch) {
+                const int s0 = batch * S;
+                const int bs = std::min(S, n_slices - s0);
+                float* sino_batch = sino_buffer + s0 * slice_size;
+                float* recon_batch = recon_buffer + s0 * recon_size;
+                if (filter) {
+                    ProfileScope timer(Stage::Filter);
+                    filter_projections(sino_batch, bs * n_angles, *filter, work.data(), w, n_angles);
+                }
+                if (packed) {
+                    ProfileScope timer(Stage::Encode);
+                    pack_rows(sino_batch, 0, bs * n_angles, n_det, plan.precision, *packed);
+                }
+                for (int unit = 0; unit < n_units; ++unit) {
+                    backproject_unit(sino_batch, packed, recon_batch, bs, s0, unit, plan, scratch, ranges);
+                }
+                if (ranges) {
+                    reduce_ranges(*ranges, bs, s0, plan);
+                    // 自动窗口要等整片的 min/max，整批一趟量化（批刚算完，多半还在 L2）
+                    if (auto_window) {
+                        ProfileScope timer(Stage::Scale);
+                        for (int b = 0; b < bs; ++b) {
+                            for (int y = 0; y < grid.ny; ++y) {
+                                quantize_output_row(recon_batch + b * recon_size + size_t(y) * grid.nx, s0 + b, y,
+                                                    0, grid.nx, ranges->slice_lo[b], ranges->slice_hi[b], plan);
+                            }
+                        }
+                    }
                 }
-                tmp_data[x] = acc;
             }
-            
-            // 将滤波后的值写回原数组
-            #pragma omp simd
-            for (int x = 0; x < n_det; ++x) {
-                row[x] = tmp_data[x];
+        } else {
+            for (int batch = 0; batch < n_batches; ++batch) {
+                const int s0 = batch * S;
+                const int bs = std::min(S, n_slices - s0);
+                float* sino_batch = sino_buffer + s0 * slice_size;
+                float* recon_batch = recon_buffer + s0 * recon_size;
+                const int n_rows = bs * n_angles;
+
+                if (filter || packed) {
+                    #pragma omp for schedule(static)
+                    for (int a = 0; a < n_rows; a += 2) {
+                        float* row_a = sino_batch + size_t(a) * n_det;
+                        float* row_b = (a + 1 < n_rows) ? row_a + n_det : nullptr;
+                        ProfileScope timer(Stage::Filter);
+                        if (filter && w) {
+                            filter_row_pair(row_a, row_b, *filter, work.data(), w[a % n_angles], w[(a + 1) % n_angles]);
+                        } else if (filter) {
+                            filter_row_pair(row_a, row_b, *filter, work.data());
+                        }
+                        timer.stop();
+                        // 刚滤完的两行还在 L1，直接编码
+                        if (packed) {
+                            ProfileScope encode_timer(Stage::Encode);
+                            pack_rows(sino_batch, a, std::min(a + 2, n_rows), n_det, plan.precision, *packed);
+                        }
+                    }
+                    // omp for 末尾的隐式 barrier 保证滤波完成后才开始反投影
+                }
+
+                #pragma omp for schedule(dynamic, 1)
+                for (int unit = 0; unit < n_units; ++unit) {
+                    backproject_unit(sino_batch, packed, recon_batch, bs, s0, unit, plan, scratch, ranges);
+                }
+
+                if (ranges) {
+                    #pragma omp single
+                    reduce_ranges(*ranges, bs, s0, plan);
+                    if (auto_window) {
+                        #pragma omp for schedule(static)
+                        for (int r = 0; r < bs * grid.ny; ++r) {
+                            ProfileScope timer(Stage::Scale);
+                            const int b = r / grid.ny, y = r % grid.ny;
+                            quantize_output_row(recon_batch + b * recon_size + size_t(y) * grid.nx, s0 + b, y,
+                                                0, grid.nx, ranges->slice_lo[b], ranges->slice_hi[b], plan);
+                        }
+                    }
+                }
             }
         }
+        total_bytes += scratch.sino_bytes;
     }
+    if (sino_bytes) *sino_bytes = total_bytes;
 }
 
 void fbp_reconstruct_3d(
@@ -95,188 +625,102 @@ void fbp_reconstruct_3d(
     int n_slices,
     int n_angles,
     int n_det,
-    const std::vector<float>& angles_deg
+    const std::vector<float>& angles_deg,
+    const FbpOptions& options
 ) {
-    const size_t slice_size = size_t(n_angles) * n_det;
-    const size_t recon_size = size_t(n_det) * n_det;
+    run_fbp(sino_buffer, recon_buffer, n_slices, n_angles, n_det, angles_deg,
+            ReconGrid(), options, true, nullptr);
+}
 
-    // ==== 采样间距（按你的真实数据设置） ====
-    const double d_det = 1.0;  // 探测器像素间距
+void fbp_reconstruct_roi_3d(
+    float* __restrict sino_buffer,
+    float* __restrict recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const ReconGrid& grid,
+    const FbpOptions& options
+) {
+    run_fbp(sino_buffer, recon_buffer, n_slices, n_angles, n_det, angles_deg,
+            grid, options, true, nullptr);
+}
 
-    // ---------- 预计算角度 & 梯形权 Δθ ----------
-    const double deg2rad = double(PI) / 180.0;
-    std::vector<double> cos_t(n_angles), sin_t(n_angles);
-    #pragma omp parallel for schedule(static)
-    for (int ai = 0; ai < n_angles; ++ai) {
-        double t = double(angles_deg[ai]) * deg2rad;
-        cos_t[ai]= std::cos(t);
-        sin_t[ai]= std::sin(t);
-    }
+void fbp_reconstruct_quantized_3d(
+    float* __restrict sino_buffer,
+    float* __restrict recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const ReconGrid& grid,
+    const QuantizedOutput& output,
+    const FbpOptions& options
+) {
+    run_fbp(sino_buffer, recon_buffer, n_slices, n_angles, n_det, angles_deg,
+            grid, options, true, nullptr, nullptr, &output);
+}
 
-    // ---------- 几何中心 ----------
-    const double cx = (n_det - 1) * 0.5;
-    const double cy = (n_det - 1) * 0.5;
-    const double t_center = (n_det - 1) * 0.5;
-    const float t_half = (n_det - 1) * 0.5f;  // Detector offset to center
-    const float scale = float(PI) / float(n_angles);  // Normalization factor from Radon inversion
-
-    // ---------- STEP 1: Ramp 滤波（带窗 + 间距一致） ----------
-    auto kernel = ramp_kernel(n_det | 1, float(d_det));
-    #pragma omp parallel for schedule(static)
-    for (int slice_id = 0; slice_id < n_slices; ++slice_id) {
-        float* sino_slice = sino_buffer + slice_id * slice_size;
-        filter_projections(sino_slice, n_angles, n_det, kernel);
-    }
+void fbp_accumulate_roi_3d(
+    float* __restrict sino_buffer,
+    float* __restrict recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const float* angle_weights,
+    const ReconGrid& grid,
+    const FbpOptions& options
+) {
+    run_fbp(sino_buffer, recon_buffer, n_slices, n_angles, n_det, angles_deg,
+            grid, options, true, nullptr, angle_weights);
+}
 
-    // 预先创建常量（避免每次循环重复创建）
-    const int32x4_t zero_vec = vdupq_n_s32(0);
-    const int32x4_t n_det_vec = vdupq_n_s32(n_det);
-    const int32x4_t one_s32 = vdupq_n_s32(1);
-    const float32x4_t zero_f = vdupq_n_f32(0.0f);
-    const float32x4_t one_f = vdupq_n_f32(1.0f);
-
-    for (int slice_id = 0; slice_id < n_slices; ++slice_id) {
-        // For each pixel in the reconstructed image
-        const float* sino_slice = sino_buffer + slice_id * slice_size;
-        float* recon_slice = recon_buffer + slice_id * recon_size;
-        
-        // 优化：改变循环顺序，先遍历y，再遍历角度
-        // 这样可以更好地利用缓存，减少 recon_row 的访问次数
-        #pragma omp parallel for schedule(static)
-        for (int y = 0; y < n_det; ++y) {
-            double yr = y - cy;  // Y coordinate relative to image center
-            float* recon_row = recon_slice + y * n_det;
-            
-            for (int ai = 0; ai < n_angles; ++ai) {
-                double c = cos_t[ai];
-                double s = sin_t[ai];
-                const float* sino_row = sino_slice + ai * n_det;
-                double last_u=-cx*c+yr*s+t_half;
-                double inc=c;
-                
-                // // 预先计算增量向量（使用 double 精度）
-                // float32x4_t inc_vec_lo = {0.0f, static_cast<float>(inc), static_cast<float>(2*inc), static_cast<float>(3*inc)};
-                // float32x4_t inc_vec_hi = {static_cast<float>(4*inc), static_cast<float>(5*inc), static_cast<float>(6*inc), static_cast<float>(7*inc)};
- 
-                int x = 0;
-                // 向量化处理，每次处理8个元素
-                for (; x + 7 < n_det; x += 8) {
-                    // 计算8个u值: last_u, last_u+inc, last_u+2*inc, ..., last_u+7*inc
-                    // 这样写会先把相加需要的两个double转换为float，再相加，导致128个测试数据中有5个chu
-                    // float32x4_t u_base_0 = vdupq_n_f32((float)last_u);
-                    // float32x4_t u_vec_lo = vaddq_f32(u_base_0, inc_vec_lo);
-                    // float32x4_t u_base_1 = vdupq_n_f32((float)(last_u+4*inc));
-                    // float32x4_t u_vec_hi = vaddq_f32(u_base_1, inc_vec_lo);
-                    
-                    float32x4_t u_vec_lo = {static_cast<float>(last_u), static_cast<float>(last_u+inc), static_cast<float>(last_u+2*inc), static_cast<float>(last_u+3*inc)};
-                    float32x4_t u_vec_hi = {static_cast<float>(last_u+4*inc), static_cast<float>(last_u+5*inc), static_cast<float>(last_u+6*inc), static_cast<float>(last_u+7*inc)};
-
-                    // 计算整数部分 u0 (使用向下取整)
-                    int32x4_t u0_lo = vcvtq_s32_f32(u_vec_lo);
-                    int32x4_t u0_hi = vcvtq_s32_f32(u_vec_hi);
-                    
-                    // 计算小数部分 du = u - u0
-                    float32x4_t du_lo = vsubq_f32(u_vec_lo, vcvtq_f32_s32(u0_lo));
-                    float32x4_t du_hi = vsubq_f32(u_vec_hi, vcvtq_f32_s32(u0_hi));
-                    
-                    // 计算 u1 = u0 + 1
-                    int32x4_t u1_lo = vaddq_s32(u0_lo, one_s32);
-                    int32x4_t u1_hi = vaddq_s32(u0_hi, one_s32);
-                    
-                    // 边界检查 - 批量处理
-                    uint32x4_t mask0_lo = vandq_u32(vcgeq_s32(u0_lo, zero_vec), vcltq_s32(u0_lo, n_det_vec));
-                    uint32x4_t mask1_lo = vandq_u32(vcgeq_s32(u1_lo, zero_vec), vcltq_s32(u1_lo, n_det_vec));
-                    uint32x4_t mask0_hi = vandq_u32(vcgeq_s32(u0_hi, zero_vec), vcltq_s32(u0_hi, n_det_vec));
-                    uint32x4_t mask1_hi = vandq_u32(vcgeq_s32(u1_hi, zero_vec), vcltq_s32(u1_hi, n_det_vec));
-                    
-                    // Gather 操作 - 优化：减少临时数组和循环开销
-                    int u0_arr[8], u1_arr[8];
-                    vst1q_s32(u0_arr, u0_lo);
-                    vst1q_s32(u0_arr + 4, u0_hi);
-                    vst1q_s32(u1_arr, u1_lo);
-                    vst1q_s32(u1_arr + 4, u1_hi);
-                    
-                    // 手动展开循环以提高效率
-                    float sino0_data[8], sino1_data[8];
-                    sino0_data[0] = sino_row[u0_arr[0]];
-                    sino0_data[1] = sino_row[u0_arr[1]];
-                    sino0_data[2] = sino_row[u0_arr[2]];
-                    sino0_data[3] = sino_row[u0_arr[3]];
-                    sino0_data[4] = sino_row[u0_arr[4]];
-                    sino0_data[5] = sino_row[u0_arr[5]];
-                    sino0_data[6] = sino_row[u0_arr[6]];
-                    sino0_data[7] = sino_row[u0_arr[7]];
-                    
-                    sino1_data[0] = sino_row[u1_arr[0]];
-                    sino1_data[1] = sino_row[u1_arr[1]];
-                    sino1_data[2] = sino_row[u1_arr[2]];
-                    sino1_data[3] = sino_row[u1_arr[3]];
-                    sino1_data[4] = sino_row[u1_arr[4]];
-                    sino1_data[5] = sino_row[u1_arr[5]];
-                    sino1_data[6] = sino_row[u1_arr[6]];
-                    sino1_data[7] = sino_row[u1_arr[7]];
-                    
-                    float32x4_t sino0_vec_lo = vld1q_f32(sino0_data);
-                    float32x4_t sino0_vec_hi = vld1q_f32(sino0_data + 4);
-                    float32x4_t sino1_vec_lo = vld1q_f32(sino1_data);
-                    float32x4_t sino1_vec_hi = vld1q_f32(sino1_data + 4);
-                    
-                    // 插值计算 - 使用 FMA (fused multiply-add) 优化
-                    // result = sino0 * (1-du) + sino1 * du
-                    //        = sino0 - sino0*du + sino1*du
-                    //        = sino0 + du*(sino1 - sino0)
-                    
-                    // lo 部分
-                    float32x4_t weight0_lo = vsubq_f32(one_f, du_lo);
-                    float32x4_t interp_lo = vmlaq_f32(vmulq_f32(sino0_vec_lo, weight0_lo), sino1_vec_lo, du_lo);
-                    
-                    // 应用边界掩码
-                    float32x4_t sum0_lo = vbslq_f32(mask0_lo, vmulq_f32(sino0_vec_lo, weight0_lo), zero_f);
-                    float32x4_t sum1_lo = vbslq_f32(mask1_lo, vmulq_f32(sino1_vec_lo, du_lo), zero_f);
-                    float32x4_t result_lo = vaddq_f32(sum0_lo, sum1_lo);
-                    
-                    // hi 部分
-                    float32x4_t weight0_hi = vsubq_f32(one_f, du_hi);
-                    float32x4_t sum0_hi = vbslq_f32(mask0_hi, vmulq_f32(sino0_vec_hi, weight0_hi), zero_f);
-                    float32x4_t sum1_hi = vbslq_f32(mask1_hi, vmulq_f32(sino1_vec_hi, du_hi), zero_f);
-                    float32x4_t result_hi = vaddq_f32(sum0_hi, sum1_hi);
-                    
-                    // 加载当前recon_row的值并累加
-                    float32x4_t recon_lo = vld1q_f32(recon_row + x);
-                    float32x4_t recon_hi = vld1q_f32(recon_row + x + 4);
-                    
-                    recon_lo = vaddq_f32(recon_lo, result_lo);
-                    recon_hi = vaddq_f32(recon_hi, result_hi);
-                    
-                    vst1q_f32(recon_row + x, recon_lo);
-                    vst1q_f32(recon_row + x + 4, recon_hi);
-                    
-                    // 更新last_u
-                    last_u += inc * 8;
-                }
-                
-                // 处理剩余的元素
-                for (; x < n_det; ++x) {
-                    double u = last_u;
-                    last_u = u + inc;
-                    
-                    int u0 = int(u);
-                    float du = u - u0;
-                    int u1 = u0 + 1;
-                    
-                    float sum0 = (u0 >= 0 && u0 < n_det) ? sino_row[u0]*(1.0f - du) : 0.0f;
-                    float sum1 = (u1 >= 0 && u1 < n_det) ? sino_row[u1]*du : 0.0f;
-                    
-                    recon_row[x] += sum0 + sum1;
-                }
+void downsample_sinogram(const float* sino, int n_slices, int n_angles, int n_det,
+    const std::vector<float>& angles_deg, int factor, std::vector<float>& out,
+    std::vector<float>& out_angles_deg, int& out_slices, int& out_det) {
+    if (factor < 1 || factor > n_det) throw std::invalid_argument("Preview factor must be in [1, n_det]");
+    out_slices = (n_slices + factor - 1) / factor;
+    out_det = n_det / factor;
+    const int out_angles = (n_angles + factor - 1) / factor;
+    out_angles_deg.resize(out_angles);
+    for (int a = 0; a < out_angles; ++a) out_angles_deg[a] = angles_deg[size_t(a) * factor];
+    out.resize(size_t(out_slices) * out_angles * out_det);
+
+    // 均值再除以 factor：线积分换算到粗像素的长度单位
+    const float norm = 1.0f / float(factor * factor);
+    #pragma omp parallel for collapse(2)
+    for (int z = 0; z < out_slices; ++z) {
+        for (int a = 0; a < out_angles; ++a) {
+            const float* __restrict src = sino + (size_t(z) * factor * n_angles + size_t(a) * factor) * n_det;
+            float* __restrict dst = out.data() + (size_t(z) * out_angles + a) * out_det;
+            for (int d = 0; d < out_det; ++d) {
+                float sum = 0;
+                for (int k = 0; k < factor; ++k) sum += src[d * factor + k];
+                dst[d] = sum * norm;
             }
         }
-        #pragma omp parallel for schedule(static)
-        for (int y = 0; y < n_det; ++y) {
-            float* __restrict row = recon_slice + y * n_det;
-            #pragma omp simd
-            for (int x = 0; x < n_det; ++x) row[x] *= scale;
-        } 
     }
-   
-}
\ No newline at end of file
+}
+
+void fbp_backproject_3d(
+    const float* sino_buffer,
+    float* recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const FbpOptions& options,
+    BackprojectStats* stats
+) {
+    auto t_start = std::chrono::steady_clock::now();
+    double sino_bytes = 0;
+    // 不滤波时 sino_buffer 只读
+    run_fbp(const_cast<float*>(sino_buffer), recon_buffer, n_slices, n_angles, n_det,
+            angles_deg, ReconGrid(), options, false, &sino_bytes);
+    auto t_end = std::chrono::steady_clock::now();
+    if (stats) {
+        stats->seconds = std::chrono::duration<double>(t_end - t_start).count();
+        stats->sino_bytes = sino_bytes;
+    }
+}
@@ -1,7 +1,176 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
+/**
+ * Apodization window applied to the ramp filter in the frequency domain
+ *
+ * With f in [0, 0.5] the normalized frequency (cycles per detector pixel):
+ *   RamLak      1                      (plain ramp, sharpest, noisiest)
+ *   SheppLogan  sin(pi*f) / (pi*f)
+ *   Cosine      cos(pi*f)
+ *   Hamming     0.54 + 0.46*cos(2*pi*f)
+ *   Hann        0.5  + 0.5 *cos(2*pi*f)  (smoothest)
+ */
+enum class FilterType {
+    RamLak,
+    SheppLogan,
+    Cosine,
+    Hamming,
+    Hann,
+};
+
+/**
+ * Parse a filter name as used on the command line
+ * (ram-lak, shepp-logan, cosine, hamming, hann)
+ *
+ * @throws std::invalid_argument on unknown names
+ */
+FilterType parse_filter_type(const std::string& name);
+
+/** Command-line name of a filter type */
+const char* filter_type_name(FilterType type);
+
+/**
+ * SIMD backend of the backprojection kernel
+ *
+ * Auto picks the fastest one compiled in and supported by the running CPU
+ * (AVX-512 > AVX2 > NEON > Scalar).
+ */
+enum class Backend {
+    Auto,
+    Scalar,
+    NEON,
+    AVX2,
+    AVX512,
+};
+
+/**
+ * Parse a backend name (auto, scalar, neon, avx2, avx512)
+ *
+ * @throws std::invalid_argument on unknown names
+ */
+Backend parse_backend(const std::string& name);
+
+/** Command-line name of a backend */
+const char* backend_name(Backend backend);
+
+/**
+ * Resolve Backend::Auto to the fastest available backend
+ *
+ * @throws std::runtime_error if an explicitly requested backend is unavailable
+ */
+Backend resolve_backend(Backend requested);
+
+/**
+ * Storage precision of the filtered sinogram read by the backprojector
+ *
+ * F32 backprojects the filter output directly. The 16-bit formats encode
+ * each filtered detector row with its own scale (see sino_codec.h) and halve
+ * the sinogram bytes read per pixel; interpolation and accumulation stay FP32.
+ */
+enum class SinoPrecision {
+    F32,
+    F16,      // IEEE half, 11-bit significand
+    BF16,     // bfloat16, 8-bit significand
+    Fixed16,  // Signed 16-bit fixed point, row peak -> 32767
+};
+
+/**
+ * Parse a precision name (f32, f16, bf16, fixed16)
+ *
+ * @throws std::invalid_argument on unknown names
+ */
+SinoPrecision parse_sino_precision(const std::string& name);
+
+/** Command-line name of a sinogram precision */
+const char* sino_precision_name(SinoPrecision precision);
+
+/**
+ * Angular quadrature weights of the backprojection sum
+ *
+ *   Uniform     pi / n_angles for every angle (angles assumed equally
+ *               spaced over 180 degrees, or 360 for cone beam)
+ *   Trapezoid   Per-angle trapezoidal d_theta of the sorted angles taken
+ *               modulo the period (180 / 360 degrees); irregular lists and
+ *               overlapping coverage (e.g. 360 degree parallel scans) share
+ *               the weight of each direction automatically
+ *   Redundancy  Trapezoid d_theta times smooth sin^2 / cos^2 redundancy
+ *               weights over the overlap of a short scan (180 + delta
+ *               degrees), parallel beam only
+ *
+ * Non-uniform weights are folded into the filtered sinogram rows, so the
+ * backprojection loop is unchanged.
+ */
+enum class AngleWeighting {
+    Uniform,
+    Trapezoid,
+    Redundancy,
+};
+
+/**
+ * Parse a weighting name (uniform, trapezoid, redundancy)
+ *
+ * @throws std::invalid_argument on unknown names
+ */
+AngleWeighting parse_angle_weighting(const std::string& name);
+
+/** Command-line name of an angle weighting */
+const char* angle_weighting_name(AngleWeighting weighting);
+
+/**
+ * Tunable options of the reconstruction engine
+ */
+struct FbpOptions {
+    FilterType filter = FilterType::RamLak;  // Ramp filter window
+    int slice_batch = 4;                     // Slices sharing interpolation coordinates (1..16)
+    Backend backend = Backend::Auto;         // Backprojection SIMD backend
+    AngleWeighting angle_weighting = AngleWeighting::Uniform;  // Per-angle d_theta weights
+
+    // Cache tiling of the backprojector: tile_size x tile_size pixel tiles,
+    // angle_block angles per detector-span buffer. tile_size = 0 keeps the
+    // row-by-row loop (each image row rereads the whole sinogram slice).
+    int tile_size = 64;
+    int angle_block = 32;
+
+    // Precomputed per-(tile, angle) detector spans and Q15.16 start
+    // coordinates, reused across calls with identical geometry, grid and
+    // tile size. Interior tiles skip the span and bounds arithmetic and run
+    // a mask-free fixed-point kernel. Needs tile_size > 0.
+    bool geometry_cache = false;
+    std::string geometry_cache_dir;          // Also persist the operator here if non-empty
+    size_t geometry_cache_max_mb = 256;      // In-memory operators kept (LRU by bytes)
+
+    // Filtered sinogram storage. 16-bit formats are decoded into the tile
+    // span buffers, so they need tile_size > 0.
+    SinoPrecision sino_precision = SinoPrecision::F32;
+};
+
+/**
+ * Output pixel grid of a reconstruction
+ *
+ * Pixel (i, j) of the nx x ny output image is centered at
+ * (x0 + i * pixel, y0 + j * pixel) in the pixel coordinates of the full
+ * n_det x n_det grid, whose center (n_det-1)/2 is the rotation axis. pixel
+ * is in detector pixels. The default (nx = ny = 0) is the full grid;
+ * backprojection cost is proportional to nx * ny.
+ */
+struct ReconGrid {
+    int nx = 0, ny = 0;    // Output size, 0 = n_det
+    double x0 = 0, y0 = 0; // Center of pixel (0, 0)
+    double pixel = 1.0;    // Pixel size
+
+    /**
+     * ROI covering full-grid pixels [x, x + w) x [y, y + h), sampled with
+     * the given pixel size (ceil(w / pixel) x ceil(h / pixel) pixels)
+     */
+    static ReconGrid roi(int x, int y, int w, int h, double pixel = 1.0);
+
+    /** Copy with nx / ny resolved for a detector of n_det pixels */
+    ReconGrid resolved(int n_det) const;
+};
+
 /**
  * Filtered Back-Projection (FBP) CT Reconstruction
  * 
@@ -14,7 +183,10 @@
  * @param n_slices      Number of slices (z-dimension)
  * @param n_angles      Number of projection angles
  * @param n_det         Number of detector pixels per projection
- * @param angles_deg    Projection angles in degrees [n_angles]
+ * @param angles_deg    Projection angles in degrees [n_angles], any order; equally
+ *                      spaced over 180 degrees unless options.angle_weighting
+ *                      is non-uniform
+ * @param options       Engine options (filter window, ...)
  */
 void fbp_reconstruct_3d(
     float* sino_buffer,
@@ -22,5 +194,137 @@ void fbp_reconstruct_3d(
     int n_slices,
     int n_angles,
     int n_det,
-    const std::vector<float>& angles_deg
+    const std::vector<float>& angles_deg,
+    const FbpOptions& options = FbpOptions()
+);
+
+/**
+ * FBP reconstruction on an arbitrary output grid (ROI, pixel size, offset)
+ *
+ * Same as fbp_reconstruct_3d, which is this function with the full grid.
+ * The geometry cache is keyed by the grid, so each ROI gets its own operator.
+ *
+ * @param recon_buffer  Output volume [n_slices, grid.ny, grid.nx]
+ * @param grid          Output grid, see ReconGrid
+ */
+void fbp_reconstruct_roi_3d(
+    float* sino_buffer,
+    float* recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const ReconGrid& grid,
+    const FbpOptions& options = FbpOptions()
+);
+
+/**
+ * Quantized copy of the reconstruction written by the backprojection
+ * epilogue (see fbp_reconstruct_quantized_3d)
+ *
+ * Pixels map [lo, hi] to [0, 2^bits - 1] with the rounding of the PNG
+ * writer (normalize_slice_u8), rows stored bottom-up like the PNG output.
+ */
+struct QuantizedOutput {
+    int bits = 8;                 // 8 (uint8_t) or 16 (uint16_t)
+    bool fixed_window = false;    // false: lo / hi = min / max of each slice
+    float lo = 0.0f, hi = 1.0f;   // Window if fixed_window
+    void* data = nullptr;         // [n_slices, grid.ny, grid.nx]
+    float* slice_min = nullptr;   // Optional: receives each slice's min [n_slices]
+    float* slice_max = nullptr;   // Optional: receives each slice's max [n_slices]
+};
+
+/**
+ * FBP reconstruction that also emits an 8/16-bit image
+ *
+ * Every tile records its min / max while it is still in cache after the
+ * last angle block. With a fixed window the tile is quantized right there;
+ * otherwise each slice batch is quantized in one pass once its tiles are
+ * done, replacing the min / max and quantization sweeps of the writer.
+ * recon_buffer receives the float volume as usual.
+ *
+ * @throws std::invalid_argument if output.bits is not 8 or 16
+ */
+void fbp_reconstruct_quantized_3d(
+    float* sino_buffer,
+    float* recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const ReconGrid& grid,
+    const QuantizedOutput& output,
+    const FbpOptions& options = FbpOptions()
+);
+
+/**
+ * Add the filtered backprojection of some angles of a scan to a volume
+ *
+ * Building block of incremental reconstruction (see IncrementalFbp): each
+ * angle's filtered row is multiplied by its d_theta weight and backprojected
+ * with +=, nothing else in recon_buffer is rescaled. Summing the calls over
+ * all angles of a scan, with the weights of the whole scan, gives the same
+ * volume as one fbp_reconstruct_roi_3d call up to float rounding. The
+ * geometry cache is not used.
+ *
+ * @param sino_buffer    Projections of these angles [n_slices, n_angles, n_det],
+ *                       filtered in place
+ * @param recon_buffer   Volume accumulated into [n_slices, grid.ny, grid.nx]
+ * @param angle_weights  d_theta of each angle in radians [n_angles]
+ *                       (pi / n for a uniform 180-degree scan of n angles)
+ */
+void fbp_accumulate_roi_3d(
+    float* sino_buffer,
+    float* recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const float* angle_weights,
+    const ReconGrid& grid,
+    const FbpOptions& options = FbpOptions()
+);
+
+/**
+ * Downsample a sinogram for a quick preview reconstruction
+ *
+ * Keeps every factor-th slice and angle and bins factor adjacent detector
+ * pixels. Bins are divided by factor^2 (average, then rescaled to the new
+ * pixel unit), so reconstructing the result on its own full grid gives the
+ * same attenuation values at 1/factor resolution, for about 1/factor^4 of
+ * the filtering and backprojection work. Trailing detector pixels that do
+ * not fill a bin are dropped (shifting the center by under half a bin).
+ *
+ * @param out         Receives [out_slices, out_angles, out_det]
+ * @param angles_deg  Angles of sino [n_angles]; the kept ones go to out_angles_deg
+ */
+void downsample_sinogram(const float* sino, int n_slices, int n_angles, int n_det,
+    const std::vector<float>& angles_deg, int factor, std::vector<float>& out,
+    std::vector<float>& out_angles_deg, int& out_slices, int& out_det);
+
+/**
+ * Statistics of a backprojection-only run
+ */
+struct BackprojectStats {
+    double seconds = 0;     // Wall time
+    double sino_bytes = 0;  // Sinogram bytes loaded by the backprojector
+};
+
+/**
+ * Backprojection only (no filtering), used to benchmark the backprojector
+ *
+ * Same scheduling, tiling and kernels as fbp_reconstruct_3d; sino_buffer is
+ * not modified and options.angle_weighting is ignored (uniform scale).
+ *
+ * @param stats  If non-null, receives wall time and sinogram traffic
+ */
+void fbp_backproject_3d(
+    const float* sino_buffer,
+    float* recon_buffer,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const FbpOptions& options = FbpOptions(),
+    BackprojectStats* stats = nullptr
 );
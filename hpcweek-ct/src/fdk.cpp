@@ -0,0 +1,147 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+
+#include "angle_weights.h"
+#include "fdk.h"
+#include "fdk_kernel.h"
+#include "ramp_filter.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+/**
+ * Maximum number of z slices sharing one set of column coordinates
+ */
+constexpr int MAX_Z_BATCH = 16;
+
+// 标量版本；AArch64 的基线即含 NEON，编译器会直接向量化
+void fdk_backproject_rows_scalar(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch) {
+    fdk_backproject_rows_impl(plan, recon, z0, Z, y, scratch);
+}
+
+static ConeKernel cone_kernel(Backend backend) {
+    switch (backend) {
+#ifdef CT_HAVE_AVX512
+        case Backend::AVX512: return fdk_backproject_rows_avx512;
+#endif
+#ifdef CT_HAVE_AVX2
+        case Backend::AVX2: return fdk_backproject_rows_avx2;
+#endif
+        default: return fdk_backproject_rows_scalar;
+    }
+}
+
+void fdk_reconstruct_3d(
+    const float* __restrict proj,
+    float* __restrict recon,
+    int n_rows,
+    int n_angles,
+    int n_cols,
+    const std::vector<float>& angles_deg,
+    const ConeGeometry& geometry,
+    const FbpOptions& options) {
+    if (!(geometry.sid > 0) || !(geometry.sdd > geometry.sid) || !(geometry.du > 0) || !(geometry.dv > 0)) {
+        throw std::invalid_argument("Cone-beam geometry needs 0 < SID < SDD and positive detector spacing");
+    }
+    if (int(angles_deg.size()) != n_angles) {
+        throw std::invalid_argument("Angle count does not match the projections");
+    }
+
+    // 探测器等效到旋转轴处（虚拟探测器），后续全部以轴处长度计算
+    const double to_axis = geometry.sid / geometry.sdd;
+    const double du_axis = geometry.du * to_axis;
+    const double dv_axis = geometry.dv * to_axis;
+    const double voxel = geometry.voxel > 0 ? geometry.voxel : du_axis;
+    const double sid = geometry.sid;
+
+    std::vector<ConeView> views(n_angles);
+    for (int ai = 0; ai < n_angles; ++ai) {
+        double b = double(angles_deg[ai]) * PI / 180.0;
+        views[ai].c = std::cos(b);
+        views[ai].s = std::sin(b);
+    }
+
+    // FDK: f = 1/2 * sum_b dβ * (sid/U)^2 * (cos 权重后的投影 ⊛ ramp)，
+    // 连续卷积离散化再乘 du_axis；这些常数全部折进预加权，反投影只剩距离权重
+    // 非均匀角度时每个视角用自己的 dβ（以 360° 为周期的梯形权重）
+    const double d_beta = 2.0 * PI / n_angles;
+    std::vector<float> view_scale(n_angles, float(0.5 * d_beta * du_axis));
+    if (options.angle_weighting != AngleWeighting::Uniform) {
+        const std::vector<float> d_betas = angle_weights(angles_deg, options.angle_weighting, 360.0);
+        for (int ai = 0; ai < n_angles; ++ai) view_scale[ai] = float(0.5 * d_betas[ai] * du_axis);
+    }
+    RampFilter filter(n_cols, float(du_axis), options.filter);
+
+    // 余弦权重 sid / sqrt(sid^2 + u^2 + v^2)，u^2 部分每列预先算好
+    std::vector<float> u2(n_cols);
+    for (int u = 0; u < n_cols; ++u) {
+        double uu = (u - (n_cols - 1) * 0.5) * du_axis;
+        u2[u] = float(uu * uu);
+    }
+
+    const int Z = std::max(1, std::min(options.slice_batch, MAX_Z_BATCH));
+    const int n_zb = (n_rows + Z - 1) / Z;
+    const int n_units = n_zb * n_cols;
+
+    // 按视角组织 [n_angles, n_rows, n_cols]：一个视角内的下标用 32 位即可表示，gather 能向量化
+    std::vector<float> filtered(size_t(n_angles) * n_rows * n_cols);
+    std::fill(recon, recon + size_t(n_rows) * n_cols * n_cols, 0.0f);
+
+    ConePlan plan;
+    plan.views_buf = filtered.data();
+    plan.n_rows = n_rows;
+    plan.n_angles = n_angles;
+    plan.n_cols = n_cols;
+    plan.views = views.data();
+    plan.sid = sid;
+    plan.voxel = voxel;
+    plan.du_axis = du_axis;
+    plan.dv_axis = dv_axis;
+    const ConeKernel kernel = cone_kernel(resolve_backend(options.backend));
+
+    #pragma omp parallel
+    {
+        std::vector<std::complex<float>> work(filter.n_fft);
+        std::vector<float> scratch;
+
+        // ---------- 余弦预加权 + 行滤波，写入按视角组织的缓冲区 ----------
+        // 同一探测器行相邻两个角度组成一对做 FFT
+        const int n_pairs = n_rows * ((n_angles + 1) / 2);
+        #pragma omp for schedule(static)
+        for (int pair = 0; pair < n_pairs; ++pair) {
+            const int v = pair / ((n_angles + 1) / 2);
+            const int a0 = (pair % ((n_angles + 1) / 2)) * 2;
+            const double vv = (v - (n_rows - 1) * 0.5) * dv_axis;
+            const float d2 = float(sid * sid + vv * vv);
+
+            float* rows[2] = {nullptr, nullptr};
+            for (int k = 0; k < 2 && a0 + k < n_angles; ++k) {
+                const float w = view_scale[a0 + k] * float(sid);
+                const float* __restrict src = proj + (size_t(v) * n_angles + a0 + k) * n_cols;
+                float* __restrict dst = filtered.data() + (size_t(a0 + k) * n_rows + v) * n_cols;
+                #pragma omp simd
+                for (int u = 0; u < n_cols; ++u) {
+                    dst[u] = src[u] * w / std::sqrt(d2 + u2[u]);
+                }
+                rows[k] = dst;
+            }
+            filter_row_pair(rows[0], rows[1], filter, work.data());
+        }
+        // omp for 的隐式 barrier：反投影要读任意探测器行
+
+        // ---------- 体素驱动反投影：(z 批, y 行) 为调度单元 ----------
+        #pragma omp for schedule(dynamic, 1)
+        for (int unit = 0; unit < n_units; ++unit) {
+            const int zb = unit / n_cols;
+            const int y = unit % n_cols;
+            const int z0 = zb * Z;
+            kernel(plan, recon, z0, std::min(Z, n_rows - z0), y, scratch);
+        }
+    }
+}
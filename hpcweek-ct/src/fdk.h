@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "fbp.h"
+
+/**
+ * Circular-orbit cone-beam geometry (flat detector)
+ *
+ * Lengths share one unit (e.g. mm). The detector u axis is parallel to
+ * the parallel-beam detector t axis at the same angle, so the cone-beam
+ * path reduces to the parallel one as sid -> infinity.
+ */
+struct ConeGeometry {
+    double sid = 0;    // Source to rotation axis distance
+    double sdd = 0;    // Source to detector distance
+    double du = 1.0;   // Detector column spacing
+    double dv = 1.0;   // Detector row spacing
+    double voxel = 0;  // Voxel size, 0 = du * sid / sdd (a detector pixel at the axis)
+};
+
+/**
+ * FDK cone-beam reconstruction of a full circular scan
+ *
+ * Projections use the same layout as parallel-beam sinograms, with the
+ * detector row in place of the slice: [n_rows, n_angles, n_cols]. Each
+ * row is cosine pre-weighted and ramp filtered with the parallel-beam
+ * filter into a view-major copy [n_angles, n_rows, n_cols] (one extra
+ * projection-sized buffer), then a voxel-driven backprojection applies the
+ * (sid / U)^2 distance weight. The output volume is [n_rows, n_cols, n_cols]
+ * voxels centered on the rotation axis. A flat-detector fan-beam scan is the
+ * n_rows = 1 case: in the mid-plane the cosine and distance weights are the
+ * fan-beam ones.
+ *
+ * Uses options.filter, options.angle_weighting (Uniform or Trapezoid over
+ * 360 degrees), and options.slice_batch as the number of z slices that
+ * share the per-(y, angle) detector column coordinates.
+ *
+ * @param proj          Projections [n_rows, n_angles, n_cols]
+ * @param recon         Output volume [n_rows, n_cols, n_cols] - overwritten
+ * @param angles_deg    Source angles in degrees, covering 360 degrees
+ * @throws std::invalid_argument on non-positive distances or sid >= sdd
+ */
+void fdk_reconstruct_3d(
+    const float* proj,
+    float* recon,
+    int n_rows,
+    int n_angles,
+    int n_cols,
+    const std::vector<float>& angles_deg,
+    const ConeGeometry& geometry,
+    const FbpOptions& options = FbpOptions()
+);
@@ -0,0 +1,9 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include "fdk_kernel.h"
+
+// 本文件单独以 -mavx512f 编译，只在运行时检测到 AVX-512F 后才会被调用
+void fdk_backproject_rows_avx512(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch) {
+    fdk_backproject_rows_impl(plan, recon, z0, Z, y, scratch);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+/**
+ * Source angle of one view
+ */
+struct ConeView {
+    double c, s;  // cos/sin of the source angle
+};
+
+/**
+ * Everything the cone-beam backprojection of one unit needs
+ */
+struct ConePlan {
+    const float* views_buf;  // Filtered, scaled projections [n_angles, n_rows, n_cols]
+    int n_rows, n_angles, n_cols;
+    const ConeView* views;
+    double sid;
+    double voxel;
+    double du_axis, dv_axis;  // Detector spacing scaled to the rotation axis
+};
+
+/**
+ * Backproject all angles into image row y of Z consecutive slices
+ *
+ * For a fixed (y, angle) the magnification sid / U and the detector column
+ * of every voxel only depend on x, so they are computed once into small
+ * row buffers and shared by the Z slices of the batch; only the detector
+ * row v = z * magnification differs per slice.
+ *
+ * Compiled once per ISA (fdk.cpp, fdk_avx2.cpp, fdk_avx512.cpp); the omp
+ * simd loops become hardware gathers where the target has them.
+ *
+ * @param plan     Geometry and filtered projections
+ * @param recon    Output volume [n_rows, n_cols, n_cols] - accumulated into
+ * @param z0, Z    First slice and number of slices
+ * @param y        Image row index
+ * @param scratch  Per-thread row buffers
+ */
+static inline void fdk_backproject_rows_impl(
+    const ConePlan& plan, float* __restrict recon, int z0, int Z, int y, std::vector<float>& scratch) {
+    const float* __restrict views_buf = plan.views_buf;
+    const int n_rows = plan.n_rows, n_angles = plan.n_angles, n_cols = plan.n_cols;
+    const ConeView* views = plan.views;
+    const double sid = plan.sid, voxel = plan.voxel, du_axis = plan.du_axis, dv_axis = plan.dv_axis;
+    const float u_max = float(n_cols + 1), v_max = float(n_rows + 1);
+    const double cx = (n_cols - 1) * 0.5;
+    const double cz = (n_rows - 1) * 0.5;
+    const float cu = float((n_cols - 1) * 0.5);
+    const float cv = float((n_rows - 1) * 0.5);
+    const double yw = y - cx;
+
+    scratch.resize(size_t(n_cols) * 3);
+    float* __restrict u_col = scratch.data();          // 探测器列坐标（像素）
+    float* __restrict mag = u_col + n_cols;            // sid / U，乘以 z 得到探测器行坐标
+    float* __restrict wdist = mag + n_cols;            // 距离权重 (sid / U)^2
+
+    for (int ai = 0; ai < n_angles; ++ai) {
+        const double c = views[ai].c;
+        const double s = views[ai].s;
+        // 体素坐标（以体素为单位）在 x = 0 处的 t、s 分量
+        const float t0 = float(-cx * c + yw * s);
+        const float s0 = float(cx * s + yw * c);
+        const float fc = float(c), fs = float(s);
+        const float fsid = float(sid);
+        const float fvoxel = float(voxel);
+        const float inv_du = float(1.0 / du_axis);
+
+        #pragma omp simd
+        for (int x = 0; x < n_cols; ++x) {
+            // t: 平行于探测器的分量；s: 指向光源的分量
+            const float t = (t0 + x * fc) * fvoxel;
+            const float sv = (s0 - x * fs) * fvoxel;
+            const float m = fsid / (fsid - sv);
+            u_col[x] = t * m * inv_du + cu;
+            mag[x] = m;
+            wdist[x] = m * m;
+        }
+
+        const float* __restrict view = views_buf + size_t(ai) * n_rows * n_cols;
+        for (int zi = 0; zi < Z; ++zi) {
+            const int z = z0 + zi;
+            const float zw = float((z - cz) * voxel / dv_axis);  // 轴处探测器行为单位
+            float* __restrict recon_row = recon + (size_t(z) * n_cols + y) * n_cols;
+
+            #pragma omp simd
+            for (int x = 0; x < n_cols; ++x) {
+                // 先夹到 [-2, n+1]：越界的点两侧权重都为 0，且非负后截断即向下取整
+                float u = u_col[x], v = zw * mag[x] + cv;
+                u = std::fmin(std::fmax(u, -2.0f), u_max) + 2.0f;
+                v = std::fmin(std::fmax(v, -2.0f), v_max) + 2.0f;
+                const int u0 = int(u) - 2, v0 = int(v) - 2;
+                const float du = u - float(u0 + 2), dv = v - float(v0 + 2);
+
+                // 越界一侧权重置 0，下标夹到合法范围（无符号比较同时判断 >= 0 和 < n）
+                const float wu0 = unsigned(u0) < unsigned(n_cols) ? 1.0f - du : 0.0f;
+                const float wu1 = unsigned(u0 + 1) < unsigned(n_cols) ? du : 0.0f;
+                const float wv0 = unsigned(v0) < unsigned(n_rows) ? 1.0f - dv : 0.0f;
+                const float wv1 = unsigned(v0 + 1) < unsigned(n_rows) ? dv : 0.0f;
+                const int iu0 = u0 < 0 ? 0 : (u0 > n_cols - 1 ? n_cols - 1 : u0);
+                const int iu1 = u0 + 1 < 0 ? 0 : (u0 + 1 > n_cols - 1 ? n_cols - 1 : u0 + 1);
+                const int iv0 = v0 < 0 ? 0 : (v0 > n_rows - 1 ? n_rows - 1 : v0);
+                const int iv1 = v0 + 1 < 0 ? 0 : (v0 + 1 > n_rows - 1 ? n_rows - 1 : v0 + 1);
+                const int r0 = iv0 * n_cols;
+                const int r1 = iv1 * n_cols;
+
+                const float p0 = view[r0 + iu0] * wu0 + view[r0 + iu1] * wu1;
+                const float p1 = view[r1 + iu0] * wu0 + view[r1 + iu1] * wu1;
+                recon_row[x] += wdist[x] * (p0 * wv0 + p1 * wv1);
+            }
+        }
+    }
+}
+
+using ConeKernel = void (*)(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch);
+
+void fdk_backproject_rows_scalar(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch);
+
+#ifdef CT_HAVE_AVX2
+void fdk_backproject_rows_avx2(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch);
+#endif
+
+#ifdef CT_HAVE_AVX512
+void fdk_backproject_rows_avx512(const ConePlan& plan, float* recon, int z0, int Z, int y,
+    std::vector<float>& scratch);
+#endif
@@ -0,0 +1,79 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "fft.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+int next_pow2(int n) {
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+FFTPlan::FFTPlan(int n) : n_(n) {
+    if (n < 1 || (n & (n - 1)) != 0) {
+        throw std::invalid_argument("FFT length must be a power of two");
+    }
+
+    int log2n = 0;
+    while ((1 << log2n) < n) ++log2n;
+
+    bitrev_.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < log2n; ++b) {
+            if (i & (1 << b)) r |= 1 << (log2n - 1 - b);
+        }
+        bitrev_[i] = r;
+    }
+
+    twiddle_.resize(std::max(1, n / 2));
+    for (int k = 0; k < n / 2; ++k) {
+        double t = -2.0 * PI * k / n;
+        twiddle_[k] = std::complex<float>(float(std::cos(t)), float(std::sin(t)));
+    }
+}
+
+void FFTPlan::forward(std::complex<float>* data) const {
+    transform(data, false);
+}
+
+void FFTPlan::inverse(std::complex<float>* data) const {
+    transform(data, true);
+}
+
+void FFTPlan::transform(std::complex<float>* __restrict data, bool inverse) const {
+    const int n = n_;
+
+    // 位反转重排
+    for (int i = 0; i < n; ++i) {
+        int j = bitrev_[i];
+        if (i < j) std::swap(data[i], data[j]);
+    }
+
+    // 迭代蝶形运算：len 为当前子变换长度，stride 为旋转因子的步长
+    const std::complex<float>* __restrict tw = twiddle_.data();
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len >> 1;
+        const int stride = n / len;
+        for (int i = 0; i < n; i += len) {
+            std::complex<float>* __restrict a = data + i;
+            std::complex<float>* __restrict b = data + i + half;
+            for (int k = 0; k < half; ++k) {
+                std::complex<float> w = tw[k * stride];
+                if (inverse) w = std::conj(w);
+                // 手动展开复数乘法，避免 std::complex 的 NaN 检查路径
+                float br = b[k].real() * w.real() - b[k].imag() * w.imag();
+                float bi = b[k].real() * w.imag() + b[k].imag() * w.real();
+                float ar = a[k].real(), ai = a[k].imag();
+                a[k] = std::complex<float>(ar + br, ai + bi);
+                b[k] = std::complex<float>(ar - br, ai - bi);
+            }
+        }
+    }
+}
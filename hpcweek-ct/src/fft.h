@@ -0,0 +1,39 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+/**
+ * Smallest power of two that is >= n
+ */
+int next_pow2(int n);
+
+/**
+ * Self-contained radix-2 complex FFT (single precision)
+ *
+ * The bit-reversal table and twiddle factors are computed once in the
+ * constructor, so a plan can be shared read-only between OpenMP threads.
+ * Twiddles are evaluated in double precision before rounding to float.
+ */
+class FFTPlan {
+public:
+    /**
+     * @param n  Transform length, must be a power of two
+     */
+    explicit FFTPlan(int n);
+
+    int size() const { return n_; }
+
+    /** In-place forward transform: X[k] = sum_j x[j] * exp(-2*pi*i*j*k/n) */
+    void forward(std::complex<float>* data) const;
+
+    /** In-place inverse transform, NOT normalized (caller scales by 1/n) */
+    void inverse(std::complex<float>* data) const;
+
+private:
+    void transform(std::complex<float>* data, bool inverse) const;
+
+    int n_;
+    std::vector<int> bitrev_;
+    std::vector<std::complex<float>> twiddle_;  // exp(-2*pi*i*k/n), k < n/2
+};
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+
+#include "geometry_cache.h"
+
+namespace fs = std::filesystem;
+
+constexpr uint32_t CACHE_MAGIC = 0x47504246;  // "FBPG"
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr int MAX_TILE = 16384;               // tile * 65536 must fit in int32
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t n_angles;
+    int32_t tile;
+    int32_t tiles_x;
+    int32_t tiles_y;
+    uint64_t hash;
+};
+
+uint64_t geometry_hash(const Geometry& geo, const ReconGrid& grid, int tile) {
+    // FNV-1a 64
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    mix(&CACHE_VERSION, sizeof(CACHE_VERSION));
+    mix(&geo.n_angles, sizeof(geo.n_angles));
+    mix(&geo.n_det, sizeof(geo.n_det));
+    mix(geo.cos_t.data(), geo.cos_t.size() * sizeof(double));
+    mix(geo.sin_t.data(), geo.sin_t.size() * sizeof(double));
+    mix(&grid.nx, sizeof(grid.nx));
+    mix(&grid.ny, sizeof(grid.ny));
+    mix(&grid.x0, sizeof(grid.x0));
+    mix(&grid.y0, sizeof(grid.y0));
+    mix(&grid.pixel, sizeof(grid.pixel));
+    mix(&tile, sizeof(tile));
+    return h;
+}
+
+static int32_t to_fixed(double v) {
+    return int32_t(std::lrint(v * (1 << BACKPROJECT_FRAC_BITS)));
+}
+
+static std::shared_ptr<GeometryOperator> build_operator(
+    const Geometry& geo, const ReconGrid& grid, int tile, uint64_t hash) {
+    const int n_angles = geo.n_angles;
+    auto op = std::make_shared<GeometryOperator>();
+    op->n_angles = n_angles;
+    op->tile = tile;
+    op->tiles_x = (grid.nx + tile - 1) / tile;
+    op->tiles_y = (grid.ny + tile - 1) / tile;
+    op->hash = hash;
+    op->spans.resize(size_t(op->tiles_x) * op->tiles_y * n_angles);
+    op->du_dx.resize(n_angles);
+    op->du_dy.resize(n_angles);
+    for (int ai = 0; ai < n_angles; ++ai) {
+        op->du_dx[ai] = to_fixed(grid.pixel * geo.cos_t[ai]);
+        op->du_dy[ai] = to_fixed(grid.pixel * geo.sin_t[ai]);
+    }
+
+    const int n_units = op->tiles_x * op->tiles_y;
+    #pragma omp parallel for schedule(static)
+    for (int unit = 0; unit < n_units; ++unit) {
+        // tile 范围和四角坐标与 backproject_tile 完全一致
+        const int y0 = (unit / op->tiles_x) * tile, y1 = std::min(grid.ny, y0 + tile);
+        const int x0 = (unit % op->tiles_x) * tile, x1 = std::min(grid.nx, x0 + tile);
+        const double xa = grid.x0 + x0 * grid.pixel - geo.cx, xb = grid.x0 + (x1 - 1) * grid.pixel - geo.cx;
+        const double ya = grid.y0 + y0 * grid.pixel - geo.cy, yb = grid.y0 + (y1 - 1) * grid.pixel - geo.cy;
+
+        GeometryOperator::Span* spans = op->spans.data() + size_t(unit) * n_angles;
+        for (int ai = 0; ai < n_angles; ++ai) {
+            const double c = geo.cos_t[ai];
+            const double s = geo.sin_t[ai];
+            int lo, len;
+            const bool interior = detector_span(xa, xb, ya, yb, c, s, geo.t_half, geo.n_det, lo, len);
+            spans[ai] = {lo, len, -1};
+            if (!interior || len >= (1 << (31 - BACKPROJECT_FRAC_BITS))) continue;
+
+            // 定点坐标带舍入误差，用四个角的定点值（与 kernel 同样的整数步进）确认两个 tap 都落在区间内
+            const int32_t u0 = to_fixed(xa * c + ya * s + geo.t_half - lo);
+            const int64_t ex = int64_t(x1 - 1 - x0) * op->du_dx[ai];
+            const int64_t ey = int64_t(y1 - 1 - y0) * op->du_dy[ai];
+            const int64_t umin = u0 + std::min<int64_t>(ex, 0) + std::min<int64_t>(ey, 0);
+            const int64_t umax = u0 + std::max<int64_t>(ex, 0) + std::max<int64_t>(ey, 0);
+            if (umin >= 0 && (umax >> BACKPROJECT_FRAC_BITS) + 1 <= len - 1) spans[ai].u0 = u0;
+        }
+    }
+    return op;
+}
+
+static fs::path cache_file(const std::string& cache_dir, uint64_t hash) {
+    char name[64];
+    snprintf(name, sizeof(name), "fbp_geom_%016llx.bin", (unsigned long long)hash);
+    return fs::path(cache_dir) / name;
+}
+
+static std::shared_ptr<GeometryOperator> load_operator(const fs::path& path,
+    int n_angles, int tile, uint64_t hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nullptr;
+
+    CacheHeader hdr{};
+    in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+    if (!in || hdr.magic != CACHE_MAGIC || hdr.version != CACHE_VERSION ||
+        hdr.n_angles != n_angles || hdr.tile != tile || hdr.hash != hash ||
+        hdr.tiles_x < 1 || hdr.tiles_y < 1) {
+        return nullptr;
+    }
+
+    auto op = std::make_shared<GeometryOperator>();
+    op->n_angles = n_angles;
+    op->tile = tile;
+    op->tiles_x = hdr.tiles_x;
+    op->tiles_y = hdr.tiles_y;
+    op->hash = hash;
+    op->spans.resize(size_t(hdr.tiles_x) * hdr.tiles_y * n_angles);
+    op->du_dx.resize(n_angles);
+    op->du_dy.resize(n_angles);
+    in.read(reinterpret_cast<char*>(op->spans.data()), op->spans.size() * sizeof(GeometryOperator::Span));
+    in.read(reinterpret_cast<char*>(op->du_dx.data()), n_angles * sizeof(int32_t));
+    in.read(reinterpret_cast<char*>(op->du_dy.data()), n_angles * sizeof(int32_t));
+    if (!in) return nullptr;
+    return op;
+}
+
+static void save_operator(const fs::path& path, const GeometryOperator& op) {
+    fs::create_directories(path.parent_path());
+    // 先写临时文件再改名，避免并发运行读到写了一半的缓存
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Cannot write geometry cache " + tmp.string());
+        CacheHeader hdr{CACHE_MAGIC, CACHE_VERSION, op.n_angles, op.tile, op.tiles_x, op.tiles_y, op.hash};
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        out.write(reinterpret_cast<const char*>(op.spans.data()), op.spans.size() * sizeof(GeometryOperator::Span));
+        out.write(reinterpret_cast<const char*>(op.du_dx.data()), op.du_dx.size() * sizeof(int32_t));
+        out.write(reinterpret_cast<const char*>(op.du_dy.data()), op.du_dy.size() * sizeof(int32_t));
+        if (!out) throw std::runtime_error("Cannot write geometry cache " + tmp.string());
+    }
+    fs::rename(tmp, path);
+}
+
+std::shared_ptr<const GeometryOperator> get_geometry_operator(
+    const Geometry& geo, const ReconGrid& grid, int tile,
+    const std::string& cache_dir, size_t memory_budget) {
+    if (tile < 1 || tile > MAX_TILE) {
+        throw std::invalid_argument("Geometry cache requires 1 <= tile <= " + std::to_string(MAX_TILE));
+    }
+
+    // 进程内缓存按字节数做 LRU：最近用过的在表头
+    static std::mutex mtx;
+    static std::list<std::shared_ptr<const GeometryOperator>> memory_cache;
+    static size_t memory_bytes = 0;
+
+    const uint64_t hash = geometry_hash(geo, grid, tile);
+    std::lock_guard<std::mutex> lock(mtx);
+
+    for (auto it = memory_cache.begin(); it != memory_cache.end(); ++it) {
+        if ((*it)->hash == hash) {
+            memory_cache.splice(memory_cache.begin(), memory_cache, it);
+            return memory_cache.front();
+        }
+    }
+
+    std::shared_ptr<GeometryOperator> op;
+    if (!cache_dir.empty()) {
+        op = load_operator(cache_file(cache_dir, hash), geo.n_angles, tile, hash);
+    }
+    if (!op) {
+        op = build_operator(geo, grid, tile, hash);
+        if (!cache_dir.empty()) {
+            try {
+                save_operator(cache_file(cache_dir, hash), *op);
+            } catch (const std::exception& e) {
+                // 磁盘缓存只是加速手段，写失败不影响重建
+                std::cerr << "Warning: " << e.what() << "\n";
+            }
+        }
+    }
+
+    // 超出预算时从表尾淘汰；单个算子就超预算则只用这一次，不常驻
+    if (op->bytes() <= memory_budget) {
+        while (!memory_cache.empty() && memory_bytes + op->bytes() > memory_budget) {
+            memory_bytes -= memory_cache.back()->bytes();
+            memory_cache.pop_back();
+        }
+        memory_cache.push_front(op);
+        memory_bytes += op->bytes();
+    }
+    return op;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backproject.h"
+
+/**
+ * Precomputed backprojection operator of the tiled backprojector for a
+ * fixed geometry, output grid and tile size
+ *
+ * u is linear in the pixel position, so a tile needs no per-pixel table:
+ * for every (tile, angle) the operator stores the detector span the tile's
+ * footprint covers (what backproject_tile copies into its buffer) and the
+ * coordinate of the tile's first pixel relative to that span in Q15.16;
+ * per angle it stores the x / y coordinate steps. Interior tiles, whose
+ * taps all lie on the detector, then run the mask-free fixed-point kernel
+ * (base index u >> 16, fraction u & 0xffff). Edge tiles are marked and keep
+ * the bounds-checked kernel.
+ *
+ * 12 bytes per (tile, angle): 1024 x 1024 pixels in 64-pixel tiles over
+ * 1024 angles take 3 MB.
+ */
+struct GeometryOperator {
+    struct Span {
+        int32_t lo;   // First detector index of the span
+        int32_t len;  // Span length
+        int32_t u0;   // u of the tile's first pixel minus lo (Q15.16), < 0: edge tile
+    };
+
+    int n_angles = 0;
+    int tile = 0;
+    int tiles_x = 0, tiles_y = 0;
+    uint64_t hash = 0;
+    std::vector<Span> spans;      // [tiles_y * tiles_x, n_angles]
+    std::vector<int32_t> du_dx;   // [n_angles] u step per pixel in x (Q15.16)
+    std::vector<int32_t> du_dy;   // [n_angles] u step per pixel in y (Q15.16)
+
+    /** Spans of all angles of one tile (unit index tile_y * tiles_x + tile_x) */
+    const Span* tile_spans(int unit) const {
+        return spans.data() + size_t(unit) * n_angles;
+    }
+    size_t bytes() const {
+        return spans.size() * sizeof(Span) + (du_dx.size() + du_dy.size()) * sizeof(int32_t);
+    }
+};
+
+/**
+ * Hash of everything the operator depends on (detector, angle bits, grid,
+ * tile size)
+ */
+uint64_t geometry_hash(const Geometry& geo, const ReconGrid& grid, int tile);
+
+/**
+ * Look up (or build) the operator for a geometry
+ *
+ * Operators are kept in a process-wide in-memory cache keyed by geometry
+ * hash; least recently used operators are dropped once the cache holds more
+ * than memory_budget bytes. If cache_dir is non-empty, the operator is also
+ * loaded from / saved to "<cache_dir>/fbp_geom_<hash>.bin", so later runs
+ * skip the build.
+ *
+ * @param grid  Resolved output grid
+ * @param tile  Tile edge of the backprojector in pixels
+ * @throws std::invalid_argument if tile is outside [1, 16384]
+ */
+std::shared_ptr<const GeometryOperator> get_geometry_operator(
+    const Geometry& geo, const ReconGrid& grid, int tile,
+    const std::string& cache_dir, size_t memory_budget);
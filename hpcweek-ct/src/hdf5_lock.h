@@ -0,0 +1,14 @@
+#pragma once
+
+#include <mutex>
+
+/**
+ * Process-wide lock for HDF5 calls made off the main thread
+ *
+ * The distro HDF5 builds are not thread-safe, so the streaming reader and
+ * the volume writer serialize every library call through this mutex.
+ */
+inline std::mutex& hdf5_mutex() {
+    static std::mutex m;
+    return m;
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "angle_weights.h"
+#include "incremental_fbp.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+void IncrementalFbp::begin(int n_slices, int n_det, const std::vector<float>& angles_deg,
+                           const ReconGrid& grid, const FbpOptions& options, int block_angles) {
+    if (n_slices < 1 || n_det < 2 || angles_deg.empty()) {
+        throw std::invalid_argument("Incremental FBP needs n_slices >= 1, n_det >= 2 and at least one angle");
+    }
+    const int n_angles = int(angles_deg.size());
+    n_slices_ = n_slices;
+    n_det_ = n_det;
+    grid_ = grid.resolved(n_det);
+    options_ = options;
+    block_angles_ = std::max(1, std::min(block_angles > 0 ? block_angles : options.angle_block, n_angles));
+    angles_ = angles_deg;
+
+    // 权重按整个扫描计划算，与一次性重建的 d_theta 相同
+    if (options.angle_weighting == AngleWeighting::Uniform) {
+        weights_.assign(n_angles, float(PI / n_angles));
+    } else {
+        weights_ = angle_weights(angles_deg, options.angle_weighting, 180.0);
+    }
+    total_weight_ = 0;
+    for (float w : weights_) total_weight_ += w;
+
+    received_.assign(n_angles, 0);
+    received_count_ = 0;
+    received_weight_ = 0;
+    volume_.assign(size_t(n_slices) * grid_.nx * grid_.ny, 0.0f);
+    pending_.resize(size_t(block_angles_) * n_slices * n_det);
+    pending_angles_.clear();
+    pending_angles_.reserve(block_angles_);
+    work_.resize(pending_.size());
+    active_ = true;
+}
+
+void IncrementalFbp::check_active() const {
+    if (!active_) throw std::logic_error("IncrementalFbp: call begin() first");
+}
+
+void IncrementalFbp::add_projections(int first_angle, int count, const float* projections) {
+    check_active();
+    if (count < 0 || first_angle < 0 || first_angle + count > angles_planned()) {
+        throw std::invalid_argument("Projections " + std::to_string(first_angle) + " + " + std::to_string(count)
+                                    + " outside the planned " + std::to_string(angles_planned()) + " angles");
+    }
+    for (int a = first_angle; a < first_angle + count; ++a) {
+        if (received_[a]) throw std::invalid_argument("Projection " + std::to_string(a) + " added twice");
+    }
+
+    const size_t frame_size = size_t(n_slices_) * n_det_;
+    for (int i = 0; i < count; ++i) {
+        const int a = first_angle + i;
+        std::memcpy(pending_.data() + pending_angles_.size() * frame_size, projections + i * frame_size,
+                    frame_size * sizeof(float));
+        pending_angles_.push_back(a);
+        received_[a] = 1;
+        ++received_count_;
+        received_weight_ += weights_[a];
+        if (int(pending_angles_.size()) == block_angles_) flush();
+    }
+}
+
+void IncrementalFbp::flush() {
+    const int k = int(pending_angles_.size());
+    if (k == 0) return;
+
+    // 探测器帧 [角度, 行, 列] 转成引擎布局 [行, 角度, 列]
+    const size_t frame_size = size_t(n_slices_) * n_det_;
+    #pragma omp parallel for
+    for (int s = 0; s < n_slices_; ++s) {
+        for (int i = 0; i < k; ++i) {
+            std::memcpy(work_.data() + (size_t(s) * k + i) * n_det_,
+                        pending_.data() + i * frame_size + size_t(s) * n_det_, n_det_ * sizeof(float));
+        }
+    }
+
+    std::vector<float> block_angles(k), block_weights(k);
+    for (int i = 0; i < k; ++i) {
+        block_angles[i] = angles_[pending_angles_[i]];
+        block_weights[i] = weights_[pending_angles_[i]];
+    }
+    fbp_accumulate_roi_3d(work_.data(), volume_.data(), n_slices_, k, n_det_, block_angles,
+                          block_weights.data(), grid_, options_);
+    pending_angles_.clear();
+}
+
+void IncrementalFbp::preview(float* out) {
+    check_active();
+    flush();
+    const float norm = received_weight_ > 0 ? float(total_weight_ / received_weight_) : 0.0f;
+    const size_t total = volume_.size();
+    #pragma omp parallel for
+    for (size_t i = 0; i < total; ++i) out[i] = volume_[i] * norm;
+}
+
+std::vector<float> IncrementalFbp::finalize() {
+    check_active();
+    flush();
+    if (received_count_ < angles_planned() && received_weight_ > 0) {
+        const float norm = float(total_weight_ / received_weight_);
+        #pragma omp parallel for
+        for (size_t i = 0; i < volume_.size(); ++i) volume_[i] *= norm;
+    }
+    active_ = false;
+    pending_ = std::vector<float>();
+    work_ = std::vector<float>();
+    return std::move(volume_);
+}
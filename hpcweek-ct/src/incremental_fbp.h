@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+
+#include "fbp.h"
+
+/**
+ * Incremental FBP for live scans: projections are filtered and backprojected
+ * as they arrive, so the volume is complete moments after the last one
+ *
+ *   IncrementalFbp recon;
+ *   recon.begin(n_rows, n_det, planned_angles, grid, options);
+ *   for each block read from the detector:
+ *       recon.add_projections(first_angle, count, block);
+ *   recon.preview(image);                  // any time
+ *   std::vector<float> volume = recon.finalize();
+ *
+ * The planned angles are needed up front for the d_theta weights
+ * (options.angle_weighting, uniform pi / n by default); projections may then
+ * arrive in any order. Incoming angles are buffered and reconstructed
+ * block_angles at a time, each block with one fbp_accumulate_roi_3d call on
+ * the calling thread. Not thread-safe: use one producer thread.
+ */
+class IncrementalFbp {
+public:
+    /**
+     * Start a scan
+     *
+     * @param n_slices      Detector rows = output slices
+     * @param n_det         Detector pixels per row
+     * @param angles_deg    All planned projection angles in degrees
+     * @param grid          Output grid, see ReconGrid
+     * @param options       Engine options; the geometry cache is not used
+     * @param block_angles  Angles buffered before a block is reconstructed
+     *                      (0: options.angle_block)
+     * @throws std::invalid_argument for empty scans or bad sizes
+     */
+    void begin(int n_slices, int n_det, const std::vector<float>& angles_deg,
+               const ReconGrid& grid = ReconGrid(), const FbpOptions& options = FbpOptions(),
+               int block_angles = 0);
+
+    /**
+     * Add projections first_angle .. first_angle + count - 1 of the plan
+     *
+     * @param projections  Detector frames [count, n_slices, n_det], one per
+     *                     angle as read from the detector; copied
+     * @throws std::invalid_argument if an angle is out of range or was
+     *         already added, std::logic_error outside begin() / finalize()
+     */
+    void add_projections(int first_angle, int count, const float* projections);
+
+    /**
+     * Current image of every slice [n_slices, ny, nx]
+     *
+     * Reconstructs the buffered angles first. While angles are missing the
+     * sum is divided by the fraction of the total weight received, so the
+     * values are on the final scale (a limited-angle image).
+     */
+    void preview(float* out);
+
+    /**
+     * Reconstruct the remaining buffered angles and hand over the volume
+     * [n_slices, ny, nx]; normalized like preview() if angles are missing.
+     * The object can then begin() a new scan.
+     */
+    std::vector<float> finalize();
+
+    int angles_received() const { return received_count_; }
+    int angles_planned() const { return int(angles_.size()); }
+    const ReconGrid& grid() const { return grid_; }
+
+private:
+    void flush();
+    void check_active() const;
+
+    bool active_ = false;
+    int n_slices_ = 0, n_det_ = 0, block_angles_ = 0;
+    ReconGrid grid_;
+    FbpOptions options_;
+    std::vector<float> angles_;            // Planned angles
+    std::vector<float> weights_;           // d_theta of each planned angle
+    std::vector<char> received_;
+    int received_count_ = 0;
+    double total_weight_ = 0, received_weight_ = 0;
+
+    std::vector<float> volume_;            // Weighted sum of the reconstructed blocks
+    std::vector<float> pending_;           // Buffered frames [block_angles, n_slices, n_det]
+    std::vector<int> pending_angles_;      // Plan indices of the buffered frames
+    std::vector<float> work_;              // Block in engine layout [n_slices, k, n_det]
+};
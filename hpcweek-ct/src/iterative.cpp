@@ -0,0 +1,232 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+
+#include "backproject.h"
+#include "iterative.h"
+
+/**
+ * Maximum number of slices sharing one set of interpolation coordinates
+ */
+constexpr int MAX_SLICE_BATCH = 16;
+
+IterativeMethod parse_iterative_method(const std::string& name) {
+    if (name == "sirt")                        return IterativeMethod::SIRT;
+    if (name == "os-sart" || name == "ossart") return IterativeMethod::OSSART;
+    throw std::invalid_argument("Unknown iterative method: " + name + " (expected sirt, os-sart)");
+}
+
+const char* iterative_method_name(IterativeMethod method) {
+    switch (method) {
+        case IterativeMethod::SIRT:   return "sirt";
+        case IterativeMethod::OSSART: return "os-sart";
+    }
+    return "unknown";
+}
+
+/**
+ * Forward project one angle of S image slices (accumulating)
+ *
+ * @param recon_slices  S images [n_det, n_det]
+ * @param sino_rows     S detector rows of angle ai [n_det] - accumulated into
+ */
+static void forward_angle(const float* const* recon_slices, float* const* sino_rows, int S, int ai,
+    const Geometry& geo) {
+    const int n_det = geo.n_det;
+    const double c = geo.cos_t[ai];
+    const double s = geo.sin_t[ai];
+    const float* rows[MAX_SLICE_BATCH];
+    for (int y = 0; y < n_det; ++y) {
+        const double yr = y - geo.cy;
+        for (int b = 0; b < S; ++b) rows[b] = recon_slices[b] + size_t(y) * n_det;
+        double u_start = -geo.cx * c + yr * s + geo.t_half;
+        forward_segment_scalar(rows, sino_rows, S, n_det, u_start, c, n_det);
+    }
+}
+
+/**
+ * Backproject the angles of one subset into image row y of S slices
+ * (accumulating), same call pattern as the FBP row mode
+ *
+ * @param sino_slices  S sinograms [n_angles, n_det]
+ * @param out_rows     S output rows [n_det] - accumulated into
+ */
+static void backproject_subset_row(const float* const* sino_slices, float* const* out_rows, int S, int y,
+    const std::vector<int>& subset, const Geometry& geo, BackprojectKernel kernel) {
+    const int n_det = geo.n_det;
+    const double yr = y - geo.cy;
+    const float* sino_rows[MAX_SLICE_BATCH];
+    for (int ai : subset) {
+        const double c = geo.cos_t[ai];
+        const double s = geo.sin_t[ai];
+        for (int b = 0; b < S; ++b) sino_rows[b] = sino_slices[b] + size_t(ai) * n_det;
+        double u_start = -geo.cx * c + yr * s + geo.t_half;
+        kernel(sino_rows, out_rows, S, n_det, u_start, c, n_det, 0);
+    }
+}
+
+static float safe_inverse(float v) {
+    return v > 1e-6f ? 1.0f / v : 0.0f;
+}
+
+std::vector<IterationStats> iterative_reconstruct_3d(
+    const float* __restrict sino,
+    float* __restrict recon,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const IterativeOptions& iter,
+    const FbpOptions& fbp) {
+    const size_t slice_size = size_t(n_angles) * n_det;
+    const size_t recon_size = size_t(n_det) * n_det;
+    const Geometry geo = make_geometry(n_angles, n_det, angles_deg);
+    const BackprojectKernel kernel = backproject_kernel(resolve_backend(fbp.backend));
+    const int S = std::max(1, std::min(fbp.slice_batch, MAX_SLICE_BATCH));
+    const int n_iter = std::max(0, iter.iterations);
+    const float lambda = iter.relaxation;
+
+    // ---------- 角度子集（交错划分，相邻子集角度互补） ----------
+    const int n_sub = iter.method == IterativeMethod::SIRT ? 1 : std::max(1, std::min(iter.subsets, n_angles));
+    std::vector<std::vector<int>> subsets(n_sub);
+    for (int a = 0; a < n_angles; ++a) subsets[a % n_sub].push_back(a);
+
+    // ---------- 系统矩阵的行和 / 列和（只依赖几何，所有 slice 共用） ----------
+    // 行和 = A * 1，列和 = B_s * 1；取倒数后作为 SIRT/SART 的归一化
+    std::vector<float> inv_row(slice_size, 0.0f);
+    std::vector<float> inv_col(size_t(n_sub) * recon_size, 0.0f);
+    {
+        const std::vector<float> ones(std::max(slice_size, recon_size), 1.0f);
+        const float* ones_ptr = ones.data();
+        #pragma omp parallel
+        {
+            #pragma omp for schedule(static)
+            for (int a = 0; a < n_angles; ++a) {
+                float* row = inv_row.data() + size_t(a) * n_det;
+                forward_angle(&ones_ptr, &row, 1, a, geo);
+                for (int d = 0; d < n_det; ++d) row[d] = safe_inverse(row[d]);
+            }
+            #pragma omp for collapse(2) schedule(static)
+            for (int sub = 0; sub < n_sub; ++sub) {
+                for (int y = 0; y < n_det; ++y) {
+                    float* row = inv_col.data() + sub * recon_size + size_t(y) * n_det;
+                    backproject_subset_row(&ones_ptr, &row, 1, y, subsets[sub], geo, kernel);
+                    for (int x = 0; x < n_det; ++x) row[x] = safe_inverse(row[x]);
+                }
+            }
+        }
+    }
+
+    // ---------- 迭代用的缓冲区：一次分配，所有批次、所有迭代复用 ----------
+    std::vector<float> resid(size_t(S) * slice_size);           // 加权残差 R (p - A x)
+    std::vector<std::vector<float>> thread_rows(omp_get_max_threads(), std::vector<float>(size_t(S) * n_det));
+    std::vector<IterationStats> stats(n_iter);
+    std::vector<double> resid_sq(n_iter, 0.0);
+    double p_sq = 0;
+
+    for (int s0 = 0; s0 < n_slices; s0 += S) {
+        const int bs = std::min(S, n_slices - s0);
+        const float* sino_batch = sino + s0 * slice_size;
+        float* recon_batch = recon + s0 * recon_size;
+
+        const float* sino_slices[MAX_SLICE_BATCH];
+        const float* resid_slices[MAX_SLICE_BATCH];
+        const float* recon_slices[MAX_SLICE_BATCH];
+        for (int b = 0; b < bs; ++b) {
+            sino_slices[b] = sino_batch + b * slice_size;
+            resid_slices[b] = resid.data() + b * slice_size;
+            recon_slices[b] = recon_batch + b * recon_size;
+        }
+
+        // 初值：FBP（借用残差缓冲区做滤波，不改动输入）或 0
+        std::fill(recon_batch, recon_batch + bs * recon_size, 0.0f);
+        if (iter.init_fbp) {
+            std::copy(sino_batch, sino_batch + bs * slice_size, resid.data());
+            FbpOptions init = fbp;
+            init.slice_batch = S;
+            fbp_reconstruct_3d(resid.data(), recon_batch, bs, n_angles, n_det, angles_deg, init);
+        }
+
+        double batch_p_sq = 0;
+        #pragma omp parallel for reduction(+:batch_p_sq) schedule(static)
+        for (size_t i = 0; i < bs * slice_size; ++i) batch_p_sq += double(sino_batch[i]) * sino_batch[i];
+        p_sq += batch_p_sq;
+
+        for (int it = 0; it < n_iter; ++it) {
+            auto t0 = std::chrono::steady_clock::now();
+            double rsq = 0;
+
+            for (int sub = 0; sub < n_sub; ++sub) {
+                const std::vector<int>& angles = subsets[sub];
+                const int n_sub_angles = int(angles.size());
+                const float* col = inv_col.data() + sub * recon_size;
+
+                #pragma omp parallel reduction(+:rsq)
+                {
+                    // ---- 前向投影 + 残差：每个角度的探测器行只由一个线程写 ----
+                    #pragma omp for schedule(dynamic, 1)
+                    for (int k = 0; k < n_sub_angles; ++k) {
+                        const int a = angles[k];
+                        float* rows[MAX_SLICE_BATCH];
+                        for (int b = 0; b < bs; ++b) {
+                            rows[b] = resid.data() + b * slice_size + size_t(a) * n_det;
+                            std::fill(rows[b], rows[b] + n_det, 0.0f);
+                        }
+                        forward_angle(recon_slices, rows, bs, a, geo);
+
+                        const float* w = inv_row.data() + size_t(a) * n_det;
+                        for (int b = 0; b < bs; ++b) {
+                            const float* p = sino_slices[b] + size_t(a) * n_det;
+                            float* r = rows[b];
+                            for (int d = 0; d < n_det; ++d) {
+                                const float diff = p[d] - r[d];
+                                rsq += double(diff) * diff;
+                                r[d] = diff * w[d];
+                            }
+                        }
+                    }
+                    // omp for 的隐式 barrier：反投影读取该子集的全部残差行
+
+                    // ---- 反投影 + 更新：按图像行划分，写入互不重叠 ----
+                    float* corr = thread_rows[omp_get_thread_num()].data();
+                    float* corr_rows[MAX_SLICE_BATCH];
+                    for (int b = 0; b < bs; ++b) corr_rows[b] = corr + size_t(b) * n_det;
+
+                    #pragma omp for schedule(dynamic, 4)
+                    for (int y = 0; y < n_det; ++y) {
+                        std::fill(corr, corr + size_t(bs) * n_det, 0.0f);
+                        backproject_subset_row(resid_slices, corr_rows, bs, y, angles, geo, kernel);
+
+                        const float* c = col + size_t(y) * n_det;
+                        for (int b = 0; b < bs; ++b) {
+                            float* __restrict x_row = recon_batch + b * recon_size + size_t(y) * n_det;
+                            const float* __restrict cr = corr_rows[b];
+                            if (iter.nonneg) {
+                                #pragma omp simd
+                                for (int x = 0; x < n_det; ++x) {
+                                    x_row[x] = std::max(0.0f, x_row[x] + lambda * c[x] * cr[x]);
+                                }
+                            } else {
+                                #pragma omp simd
+                                for (int x = 0; x < n_det; ++x) x_row[x] += lambda * c[x] * cr[x];
+                            }
+                        }
+                    }
+                }
+            }
+
+            stats[it].seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            resid_sq[it] += rsq;
+        }
+    }
+
+    for (int it = 0; it < n_iter; ++it) {
+        stats[it].residual = p_sq > 0 ? std::sqrt(resid_sq[it] / p_sq) : 0.0;
+    }
+    return stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "fbp.h"
+
+enum class IterativeMethod {
+    SIRT,   // Simultaneous update from all angles per iteration
+    OSSART  // Ordered-subsets SART: one update per angle subset
+};
+
+/**
+ * @throws std::invalid_argument for unknown names
+ */
+IterativeMethod parse_iterative_method(const std::string& name);
+const char* iterative_method_name(IterativeMethod method);
+
+struct IterativeOptions {
+    IterativeMethod method = IterativeMethod::SIRT;
+    int iterations = 10;
+    int subsets = 10;           // OS-SART only, interleaved angle subsets
+    float relaxation = 1.0f;    // Update step lambda
+    bool nonneg = true;         // Clamp the image to >= 0 after each update
+    bool init_fbp = true;       // Start from FBP (options.fbp), otherwise from zero
+};
+
+struct IterationStats {
+    double seconds = 0;   // Wall time of the iteration over the whole volume
+    double residual = 0;  // ||p - A x|| / ||p|| seen during the iteration
+};
+
+/**
+ * SIRT / OS-SART reconstruction of a parallel-beam volume
+ *
+ * A is the forward projector matched to the FBP backprojector B (A = B^T,
+ * see forward_segment_scalar); B runs on the selected SIMD backend. Each
+ * (sub)iteration computes
+ *
+ *   x += lambda * C_s * B_s * R * (p_s - A_s x)
+ *
+ * where R / C_s are the inverse row / column sums of the system matrix over
+ * the angles of subset s (a single subset for SIRT). Slices are processed in
+ * batches of options.slice_batch sharing coordinates; forward projection is
+ * parallel over angles, backprojection over image rows. All buffers are
+ * allocated once and reused across iterations and batches.
+ *
+ * For OS-SART the residual of an iteration accumulates the subset residuals
+ * as they are computed, i.e. against the image being updated.
+ *
+ * @param sino         Sinograms [n_slices, n_angles, n_det], not modified
+ * @param recon        Output volume [n_slices, n_det, n_det] - overwritten
+ * @param angles_deg   Projection angles in degrees
+ * @param iter         Method and iteration options
+ * @param fbp          Backend / slice batch, and filter for the FBP start
+ * @return             Per-iteration statistics
+ */
+std::vector<IterationStats> iterative_reconstruct_3d(
+    const float* sino,
+    float* recon,
+    int n_slices,
+    int n_angles,
+    int n_det,
+    const std::vector<float>& angles_deg,
+    const IterativeOptions& iter,
+    const FbpOptions& fbp = FbpOptions()
+);
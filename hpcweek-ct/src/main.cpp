@@ -1,86 +1,472 @@
 #include <H5Cpp.h>
-#include <opencv2/opencv.hpp>
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <iostream>
-#include <numeric>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <fstream>
 #include <algorithm>
 #include <chrono>
+#include <omp.h>
 #include "fbp.h"
+#include "fdk.h"
+#include "incremental_fbp.h"
+#include "iterative.h"
+#include "profiler.h"
+#include "sino_input.h"
+#include "slab_reader.h"
+#include "volume_writer.h"
 
 namespace fs = std::filesystem;
 
-static std::vector<hsize_t> get_shape(const H5::DataSet& ds) {
-    H5::DataSpace sp = ds.getSpace();
-    int nd = sp.getSimpleExtentNdims();
-    std::vector<hsize_t> dims(nd);
-    sp.getSimpleExtentDims(dims.data(), nullptr);
-    return dims;
+static bool read_scalar_attr(const H5::DataSet& ds, const char* name, double& value) {
+    if (!ds.attrExists(name)) return false;
+    ds.openAttribute(name).read(H5::PredType::NATIVE_DOUBLE, &value);
+    return true;
 }
 
-static void read_dataset_float32(const H5::DataSet& ds, std::vector<float>& out, std::vector<hsize_t>& shape) {
-    shape = get_shape(ds);
-    H5::DataType t = ds.getDataType();
-    out.resize(std::accumulate(shape.begin(), shape.end(), hsize_t(1), std::multiplies<hsize_t>()));
-    
-    if (t == H5::PredType::NATIVE_FLOAT) {
-        ds.read(out.data(), H5::PredType::NATIVE_FLOAT);
-    } else if (t == H5::PredType::NATIVE_DOUBLE) {
-        std::vector<double> tmp(out.size());
-        ds.read(tmp.data(), H5::PredType::NATIVE_DOUBLE);
-        for (size_t i = 0; i < out.size(); ++i) out[i] = static_cast<float>(tmp[i]);
-    } else {
-        throw std::runtime_error("Unsupported data type");
+/**
+ * Cone-beam geometry from attributes of the projection dataset
+ *
+ * SID and SDD mark the data as cone-beam; du / dv (detector spacing,
+ * default 1, dv defaults to du) and voxel are optional.
+ *
+ * @return false if the dataset carries no cone-beam geometry
+ */
+static bool read_cone_geometry(const H5::DataSet& ds, ConeGeometry& geo) {
+    if (!read_scalar_attr(ds, "SID", geo.sid) || !read_scalar_attr(ds, "SDD", geo.sdd)) return false;
+    read_scalar_attr(ds, "du", geo.du);
+    geo.dv = geo.du;
+    read_scalar_attr(ds, "dv", geo.dv);
+    read_scalar_attr(ds, "voxel", geo.voxel);
+    return true;
+}
+
+struct CliOptions {
+    std::string input;
+    FbpOptions fbp;
+    int bench_reps = 0;  // > 0: benchmark backprojection only, no output
+    std::string angles_path;          // Angle dataset, empty: /angles if present, else uniform
+    bool angle_weighting_set = false; // --angle-weights given (else trapezoid for file angles)
+    std::vector<int> roi;             // x, y, w, h in full-grid pixels, empty = full grid
+    double pixel_size = 1.0;          // Output pixel size in detector pixels
+    int preview = 0;                  // > 1: downsampled preview by this factor
+    bool validate_precision = false;  // Also run FP32 and report the error of --sino-precision
+    int stream_slices = 0;  // > 0: read and reconstruct slab by slab
+    int stream_buffers = 3;
+    OutputFormat output = OutputFormat::PNG;
+    int output_threads = 4;
+    int png_bits = 8;
+    bool fused_output = false;        // Quantize PNG slices in the backprojection epilogue
+    std::vector<float> window;        // Fixed grey-level window lo, hi (--fused-output), empty = per slice
+    bool iterative = false;
+    IterativeOptions iter;
+    int live_block = 0;               // > 0: feed angles in blocks of this size to IncrementalFbp
+    std::string profile_path;         // Non-empty: per-stage profile, JSON written here
+    bool perf_counters = false;       // Hardware counters for backprojection (--profile)
+};
+
+static void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " <hdf5_file> [options]\n"
+              << "Options:\n"
+              << "  --filter <name>   Ramp filter window: ram-lak (default), shepp-logan,\n"
+              << "                    cosine, hamming, hann\n"
+              << "  --slice-batch <S> Slices sharing interpolation coordinates in\n"
+              << "                    backprojection, 1..16 (default 4)\n"
+              << "  --backend <name>  Backprojection SIMD backend: auto (default), scalar,\n"
+              << "                    neon, avx2, avx512\n"
+              << "  --geometry-cache  Precompute the per-tile backprojection operator for this geometry\n"
+              << "  --geometry-cache-dir <dir>\n"
+              << "                    Also load/save the operator in <dir> (implies --geometry-cache)\n"
+              << "  --tile <N>        Backprojection pixel tile edge, 0 = row by row (default 64)\n"
+              << "  --angle-block <N> Angles per cached detector span in tile mode (default 32)\n"
+              << "  --angles <dset>   Angle dataset in the input file (default /angles if present,\n"
+              << "                    else uniform over 180, or 360 degrees for cone beam)\n"
+              << "  --angle-weights <w>\n"
+              << "                    Per-angle weights: uniform, trapezoid (default for angles\n"
+              << "                    read from the file), redundancy (short scans)\n"
+              << "  --roi <x,y,w,h>   Reconstruct only full-grid pixels [x, x+w) x [y, y+h)\n"
+              << "  --pixel-size <p>  Output pixel size in detector pixels (default 1)\n"
+              << "  --preview <F>     Quick preview: every F-th slice and angle, F detector pixels\n"
+              << "                    binned, output downsampled F times\n"
+              << "  --sino-precision <p>\n"
+              << "                    Filtered sinogram storage: f32 (default), f16, bf16, fixed16\n"
+              << "  --validate-precision\n"
+              << "                    Also reconstruct with f32 and report the error against it\n"
+              << "  --bench <reps>    Benchmark backprojection only: report time, Mvoxels/s and\n"
+              << "                    GB/s of sinogram traffic, write no images\n"
+              << "  --stream <N>      Read, reconstruct and save N slices at a time; the next\n"
+              << "                    slabs are read on an I/O thread meanwhile (default 0 = off)\n"
+              << "  --stream-buffers <N>\n"
+              << "                    Slab buffers in the read-ahead ring, >= 2 (default 3)\n"
+              << "  --output <fmt>    png (default, one image per slice), raw or hdf5 (a single\n"
+              << "                    float32 volume in recon_out/)\n"
+              << "  --output-threads <N>\n"
+              << "                    Threads encoding and writing slices in the background (default 4)\n"
+              << "  --png-bits <N>    Bits per PNG pixel: 8 (default) or 16\n"
+              << "  --fused-output    Quantize the PNG slices in the backprojection epilogue\n"
+              << "  --window <lo,hi>  With --fused-output: fixed grey-level window instead of each\n"
+              << "                    slice's min / max, quantized while the tile is in cache\n"
+              << "  --iterative <name> Iterative reconstruction instead of FBP: sirt, os-sart\n"
+              << "  --iterations <N>  Iterations (default 10)\n"
+              << "  --subsets <N>     OS-SART angle subsets (default 10)\n"
+              << "  --relaxation <l>  Update step (default 1.0)\n"
+              << "  --no-fbp-init     Start iterating from zero instead of the FBP image\n"
+              << "  --allow-negative  Do not clamp the image to >= 0 between updates\n"
+              << "  --live <N>        Simulate a live scan: add projections N angles at a time to\n"
+              << "                    the incremental reconstructor as they \"arrive\"\n"
+              << "  --profile <file>  Time read, convert, filter, encode, backproject, scale and\n"
+              << "                    write per thread; print a summary and save it as JSON\n"
+              << "  --perf-counters   With --profile: cycles, instructions and cache misses of\n"
+              << "                    backprojection via perf_event_open (Linux)\n";
+}
+
+static bool parse_args(int argc, char** argv, CliOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next_value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--filter") {
+            opts.fbp.filter = parse_filter_type(next_value());
+        } else if (arg == "--slice-batch") {
+            opts.fbp.slice_batch = std::stoi(next_value());
+            if (opts.fbp.slice_batch < 1 || opts.fbp.slice_batch > 16) {
+                throw std::invalid_argument("--slice-batch must be in 1..16");
+            }
+        } else if (arg == "--backend") {
+            opts.fbp.backend = parse_backend(next_value());
+        } else if (arg == "--geometry-cache") {
+            opts.fbp.geometry_cache = true;
+        } else if (arg == "--geometry-cache-dir") {
+            opts.fbp.geometry_cache = true;
+            opts.fbp.geometry_cache_dir = next_value();
+        } else if (arg == "--tile") {
+            opts.fbp.tile_size = std::stoi(next_value());
+            if (opts.fbp.tile_size < 0) throw std::invalid_argument("--tile must be >= 0");
+        } else if (arg == "--angle-block") {
+            opts.fbp.angle_block = std::stoi(next_value());
+            if (opts.fbp.angle_block < 1) throw std::invalid_argument("--angle-block must be >= 1");
+        } else if (arg == "--angles") {
+            opts.angles_path = next_value();
+        } else if (arg == "--angle-weights") {
+            opts.fbp.angle_weighting = parse_angle_weighting(next_value());
+            opts.angle_weighting_set = true;
+        } else if (arg == "--roi") {
+            std::string v = next_value();
+            opts.roi.clear();
+            size_t pos = 0;
+            while (pos <= v.size()) {
+                size_t comma = v.find(',', pos);
+                if (comma == std::string::npos) comma = v.size();
+                opts.roi.push_back(std::stoi(v.substr(pos, comma - pos)));
+                pos = comma + 1;
+            }
+            if (opts.roi.size() != 4 || opts.roi[2] < 1 || opts.roi[3] < 1) {
+                throw std::invalid_argument("--roi expects x,y,w,h with w, h >= 1");
+            }
+        } else if (arg == "--pixel-size") {
+            opts.pixel_size = std::stod(next_value());
+            if (!(opts.pixel_size > 0)) throw std::invalid_argument("--pixel-size must be > 0");
+        } else if (arg == "--preview") {
+            opts.preview = std::stoi(next_value());
+            if (opts.preview < 2) throw std::invalid_argument("--preview must be >= 2");
+        } else if (arg == "--sino-precision") {
+            opts.fbp.sino_precision = parse_sino_precision(next_value());
+        } else if (arg == "--validate-precision") {
+            opts.validate_precision = true;
+        } else if (arg == "--bench") {
+            opts.bench_reps = std::stoi(next_value());
+            if (opts.bench_reps < 1) throw std::invalid_argument("--bench must be >= 1");
+        } else if (arg == "--stream") {
+            opts.stream_slices = std::stoi(next_value());
+            if (opts.stream_slices < 0) throw std::invalid_argument("--stream must be >= 0");
+        } else if (arg == "--stream-buffers") {
+            opts.stream_buffers = std::stoi(next_value());
+            if (opts.stream_buffers < 2) throw std::invalid_argument("--stream-buffers must be >= 2");
+        } else if (arg == "--output") {
+            opts.output = parse_output_format(next_value());
+        } else if (arg == "--output-threads") {
+            opts.output_threads = std::stoi(next_value());
+            if (opts.output_threads < 1) throw std::invalid_argument("--output-threads must be >= 1");
+        } else if (arg == "--png-bits") {
+            opts.png_bits = std::stoi(next_value());
+            if (opts.png_bits != 8 && opts.png_bits != 16) throw std::invalid_argument("--png-bits must be 8 or 16");
+        } else if (arg == "--fused-output") {
+            opts.fused_output = true;
+        } else if (arg == "--window") {
+            std::string v = next_value();
+            size_t comma = v.find(',');
+            if (comma == std::string::npos) throw std::invalid_argument("--window expects lo,hi");
+            opts.window = {std::stof(v.substr(0, comma)), std::stof(v.substr(comma + 1))};
+            if (!(opts.window[1] > opts.window[0])) throw std::invalid_argument("--window needs lo < hi");
+        } else if (arg == "--iterative") {
+            opts.iterative = true;
+            opts.iter.method = parse_iterative_method(next_value());
+        } else if (arg == "--iterations") {
+            opts.iter.iterations = std::stoi(next_value());
+            if (opts.iter.iterations < 1) throw std::invalid_argument("--iterations must be >= 1");
+        } else if (arg == "--subsets") {
+            opts.iter.subsets = std::stoi(next_value());
+            if (opts.iter.subsets < 1) throw std::invalid_argument("--subsets must be >= 1");
+        } else if (arg == "--relaxation") {
+            opts.iter.relaxation = std::stof(next_value());
+            if (!(opts.iter.relaxation > 0)) throw std::invalid_argument("--relaxation must be > 0");
+        } else if (arg == "--no-fbp-init") {
+            opts.iter.init_fbp = false;
+        } else if (arg == "--allow-negative") {
+            opts.iter.nonneg = false;
+        } else if (arg == "--live") {
+            opts.live_block = std::stoi(next_value());
+            if (opts.live_block < 1) throw std::invalid_argument("--live must be >= 1");
+        } else if (arg == "--profile") {
+            opts.profile_path = next_value();
+        } else if (arg == "--perf-counters") {
+            opts.perf_counters = true;
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option: " + arg);
+        } else if (opts.input.empty()) {
+            opts.input = arg;
+        } else {
+            throw std::invalid_argument("Unexpected argument: " + arg);
+        }
+    }
+    if (opts.bench_reps > 0 && opts.stream_slices > 0) {
+        throw std::invalid_argument("--bench needs the whole volume, it cannot be combined with --stream");
+    }
+    if (opts.iterative && (opts.bench_reps > 0 || opts.stream_slices > 0)) {
+        throw std::invalid_argument("--iterative cannot be combined with --bench or --stream");
+    }
+    const bool custom_grid = !opts.roi.empty() || opts.pixel_size != 1.0;
+    if ((custom_grid || opts.preview > 0) && (opts.bench_reps > 0 || opts.iterative)) {
+        throw std::invalid_argument("--roi, --pixel-size and --preview cannot be combined with --bench or --iterative");
+    }
+    if (opts.preview > 0 && (custom_grid || opts.stream_slices > 0)) {
+        throw std::invalid_argument("--preview cannot be combined with --roi, --pixel-size or --stream");
+    }
+    if (opts.live_block > 0 && (opts.bench_reps > 0 || opts.stream_slices > 0 || opts.iterative)) {
+        throw std::invalid_argument("--live cannot be combined with --bench, --stream or --iterative");
+    }
+    if (!opts.window.empty() && !opts.fused_output) {
+        throw std::invalid_argument("--window needs --fused-output");
+    }
+    if (opts.fused_output && (opts.output != OutputFormat::PNG || opts.bench_reps > 0 || opts.iterative
+                              || opts.live_block > 0)) {
+        throw std::invalid_argument("--fused-output needs PNG output and cannot be combined with --bench, "
+                                    "--iterative or --live");
+    }
+    if (opts.perf_counters && opts.profile_path.empty()) {
+        throw std::invalid_argument("--perf-counters needs --profile");
+    }
+    if (opts.validate_precision) {
+        if (opts.fbp.sino_precision == SinoPrecision::F32) {
+            throw std::invalid_argument("--validate-precision needs a 16-bit --sino-precision");
+        }
+        if (opts.bench_reps > 0 || opts.stream_slices > 0 || opts.iterative) {
+            throw std::invalid_argument("--validate-precision cannot be combined with --bench, --stream or --iterative");
+        }
+    }
+    return !opts.input.empty();
+}
+
+/**
+ * Print the error of a reduced-precision reconstruction against the FP32 one
+ *
+ * Errors are relative to the dynamic range of the reference volume, the same
+ * normalization the PNG output applies.
+ */
+static void report_precision_error(const std::vector<float>& ref, const std::vector<float>& test,
+                                   SinoPrecision precision) {
+    float lo = ref[0], hi = ref[0];
+    double max_err = 0, sum_sq = 0;
+    #pragma omp parallel for reduction(min:lo) reduction(max:hi, max_err) reduction(+:sum_sq)
+    for (size_t i = 0; i < ref.size(); ++i) {
+        lo = std::min(lo, ref[i]);
+        hi = std::max(hi, ref[i]);
+        double d = double(test[i]) - ref[i];
+        max_err = std::max(max_err, std::fabs(d));
+        sum_sq += d * d;
     }
+    const double range = std::max(double(hi) - lo, 1e-30);
+    const double rmse = std::sqrt(sum_sq / double(ref.size()));
+    std::cout << "Precision check (" << sino_precision_name(precision) << " vs f32): max error "
+              << (max_err / range) << ", RMSE " << (rmse / range) << " of the value range, PSNR "
+              << (rmse > 0 ? 20.0 * std::log10(range / rmse) : INFINITY) << " dB\n";
+}
+
+/**
+ * Print the stage profile and save it as JSON (--profile)
+ *
+ * The config entries identify the run so that profiles of different builds
+ * and settings can be diffed.
+ */
+static void report_profile(const CliOptions& opts, std::chrono::steady_clock::time_point t_start,
+                           int n_slices, int n_angles, int n_det, const char* method) {
+    if (opts.profile_path.empty()) return;
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cout << "\n";
+    print_profile_summary(std::cout, wall_s);
+
+    std::vector<std::pair<std::string, std::string>> config = {
+        {"input", opts.input},
+        {"shape", std::to_string(n_slices) + "x" + std::to_string(n_angles) + "x" + std::to_string(n_det)},
+        {"method", method},
+        {"mode", opts.bench_reps > 0 ? "bench" : opts.stream_slices > 0 ? "stream" : "in-memory"},
+        {"filter", filter_type_name(opts.fbp.filter)},
+        {"backend", backend_name(resolve_backend(opts.fbp.backend))},
+        {"slice_batch", std::to_string(opts.fbp.slice_batch)},
+        {"tile", std::to_string(opts.fbp.tile_size)},
+        {"angle_block", std::to_string(opts.fbp.angle_block)},
+        {"geometry_cache", opts.fbp.geometry_cache ? "on" : "off"},
+        {"sino_precision", sino_precision_name(opts.fbp.sino_precision)},
+        {"angle_weights", angle_weighting_name(opts.fbp.angle_weighting)},
+        {"output", output_format_name(opts.output)},
+        {"omp_threads", std::to_string(omp_get_max_threads())},
+        {"compiler", __VERSION__},
+    };
+    write_profile_json(opts.profile_path, wall_s, config);
+    std::cout << "Profile saved to " << opts.profile_path << "\n";
 }
 
-static std::vector<float> generate_angles(int n_angles) {
-    std::vector<float> angles(n_angles);
-    for (int i = 0; i < n_angles; ++i) {
-        angles[i] = 180.0f * i / n_angles;
+/**
+ * Quantized PNG slices of n_slices x grid for --fused-output
+ *
+ * @param pixels  Resized to hold them
+ */
+static QuantizedOutput fused_output(const CliOptions& opts, int n_slices, const ReconGrid& grid,
+                                    std::vector<uint8_t>& pixels) {
+    pixels.resize(size_t(n_slices) * grid.nx * grid.ny * (opts.png_bits / 8));
+    QuantizedOutput q;
+    q.bits = opts.png_bits;
+    q.data = pixels.data();
+    if (!opts.window.empty()) {
+        q.fixed_window = true;
+        q.lo = opts.window[0];
+        q.hi = opts.window[1];
     }
-    return angles;
+    return q;
 }
 
-static void save_png(const fs::path& path, const float* img, int h, int w) {
-    fs::create_directories(path.parent_path());
-    
-    float mn = img[0], mx = img[0];
-    size_t total = size_t(h) * w;
-    for (size_t i = 0; i < total; ++i) { 
-        mn = std::min(mn, img[i]); 
-        mx = std::max(mx, img[i]); 
-    }
-    float den = (mx > mn) ? (mx - mn) : 1.0f;
-    
-    cv::Mat mat(h, w, CV_8UC1);
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            float v = (img[y * w + x] - mn) / den;
-            mat.at<uint8_t>(h - 1 - y, x) = std::max(0, std::min(255, int(std::round(v * 255.0f))));
-        }
-    }
-    
-    cv::imwrite(path.string(), mat);
+/**
+ * Replay the sinogram as a live scan through IncrementalFbp
+ *
+ * Angles are handed over live_block at a time as detector frames
+ * [angles, rows, detectors], the layout a detector delivers.
+ */
+static void reconstruct_live(const std::vector<float>& sino, int n_slices, int n_angles, int n_det,
+                             const std::vector<float>& angles, const ReconGrid& grid, const CliOptions& opts,
+                             std::vector<float>& recon) {
+    const int block = std::min(opts.live_block, n_angles);
+    IncrementalFbp live;
+    live.begin(n_slices, n_det, angles, grid, opts.fbp, block);
+
+    std::vector<float> frames(size_t(block) * n_slices * n_det);
+    std::chrono::steady_clock::time_point t_last;
+    for (int a0 = 0; a0 < n_angles; a0 += block) {
+        const int k = std::min(block, n_angles - a0);
+        for (int i = 0; i < k; ++i) {
+            for (int s = 0; s < n_slices; ++s) {
+                const float* src = sino.data() + (size_t(s) * n_angles + a0 + i) * n_det;
+                std::copy(src, src + n_det, frames.data() + (size_t(i) * n_slices + s) * n_det);
+            }
+        }
+        t_last = std::chrono::steady_clock::now();
+        live.add_projections(a0, k, frames.data());
+    }
+    recon = live.finalize();
+    std::cout << "Final image ready "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_last).count()
+              << " ms after the last block arrived (" << block << " angles per block)\n";
+}
+
+/**
+ * Reconstruct slab by slab while an I/O thread reads ahead
+ *
+ * Only stream_buffers sinogram slabs and one reconstructed slab are held
+ * in memory, so volumes larger than RAM can be processed.
+ */
+static void reconstruct_streaming(const H5::DataSet& ds, int n_slices, int n_angles, int n_det,
+                                  const std::vector<float>& angles, const ReconGrid& grid,
+                                  const CliOptions& opts) {
+    std::cout << "\nStreaming FBP reconstruction (filter: " << filter_type_name(opts.fbp.filter)
+              << ", backend: " << backend_name(resolve_backend(opts.fbp.backend))
+              << ", " << opts.stream_slices << " slices per slab, "
+              << opts.stream_buffers << " buffers)...\n";
+    size_t recon_size = size_t(grid.nx) * grid.ny;
+    VolumeWriter writer(opts.output, "recon_out", n_slices, grid.ny, grid.nx, opts.output_threads,
+                        std::max(opts.stream_slices, 2 * opts.output_threads), opts.png_bits);
+
+    double recon_s = 0, wait_s = 0;
+    auto t_start = std::chrono::steady_clock::now();
+
+    SlabReader reader(ds, opts.stream_slices, opts.stream_buffers);
+    for (;;) {
+        auto t0 = std::chrono::steady_clock::now();
+        SinoSlab* slab = reader.next();
+        auto t1 = std::chrono::steady_clock::now();
+        wait_s += std::chrono::duration<double>(t1 - t0).count();
+        if (!slab) break;
+
+        // 每个 slab 一块新的输出缓冲区，交给写线程后由其释放
+        std::vector<float> recon_slab(slab->count * recon_size);
+        std::vector<uint8_t> pixels;
+        if (opts.fused_output) {
+            fbp_reconstruct_quantized_3d(slab->data.data(), recon_slab.data(), slab->count, n_angles, n_det,
+                                         angles, grid, fused_output(opts, slab->count, grid, pixels), opts.fbp);
+        } else {
+            fbp_reconstruct_roi_3d(slab->data.data(), recon_slab.data(), slab->count, n_angles, n_det,
+                                   angles, grid, opts.fbp);
+        }
+        recon_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+        int first = slab->first, count = slab->count;
+        reader.release(slab);  // 先归还缓冲区，I/O 线程可以继续读
+        if (opts.fused_output) {
+            writer.write_quantized(first, count, std::move(pixels));
+        } else {
+            writer.write(first, count, std::move(recon_slab));
+        }
+    }
+    writer.finish();
+
+    double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cout << "Streaming completed in " << total_s << " seconds (reconstruction " << recon_s
+              << " s, HDF5 read " << reader.read_seconds() << " s, waiting for I/O " << wait_s << " s)\n";
+    std::cout << "Average time per slice: " << (total_s * 1000.0 / n_slices) << " ms\n";
+    std::cout << "Throughput: " << (double(n_slices) * recon_size / std::max(recon_s, 1e-3) / 1e6)
+              << " Mvoxels/s reconstruction\n";
+    std::cout << "All results saved to " << writer.path() << " (" << output_format_name(opts.output) << ")\n";
+    report_profile(opts, t_start, n_slices, n_angles, n_det, "FBP");
 }
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <hdf5_file>\n";
+    CliOptions opts;
+    try {
+        if (!parse_args(argc, argv, opts)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        print_usage(argv[0]);
         return 1;
     }
 
     try {
+        const auto t_program = std::chrono::steady_clock::now();
+        if (!opts.profile_path.empty()) profiler_enable(opts.perf_counters);
+
         // ============================================================
         // Load HDF5 sinogram data
         // ============================================================
         
-        H5::H5File f(argv[1], H5F_ACC_RDONLY);
+        H5::H5File f(opts.input, H5F_ACC_RDONLY);
         std::cout << "HDF5 file: " << f.getFileName() << "\n";
         
         std::string dset_path = "/data";
@@ -104,18 +490,54 @@ int main(int argc, char** argv) {
         int n_det = int(shape[2]);
         std::cout << "Data shape: [" << n_slices << " slices, " 
                   << n_angles << " angles, " << n_det << " detectors]\n";
-        
+
+        ConeGeometry cone;
+        const bool cone_beam = read_cone_geometry(ds, cone);
+        if (cone_beam) {
+            std::cout << "Cone-beam geometry: SID " << cone.sid << ", SDD " << cone.sdd
+                      << ", detector spacing " << cone.du << " x " << cone.dv << "\n";
+            if (opts.stream_slices > 0 || opts.bench_reps > 0 || opts.iterative || opts.live_block > 0
+                || opts.fused_output || opts.fbp.sino_precision != SinoPrecision::F32
+                || opts.preview > 0 || !opts.roi.empty() || opts.pixel_size != 1.0) {
+                throw std::runtime_error("--stream, --bench, --iterative, --live, --fused-output, --sino-precision, "
+                                         "--roi, --pixel-size and --preview support parallel-beam data only");
+            }
+        }
+
+        // 角度优先从文件读取；否则均匀分布：平行束 [0, 180)，锥束整圈 [0, 360)
+        std::string angles_path;
+        std::vector<float> angles = load_angles(f, opts.angles_path, n_angles, cone_beam ? 360.0f : 180.0f,
+                                                angles_path);
+        if (!angles_path.empty()) {
+            if (!opts.angle_weighting_set) opts.fbp.angle_weighting = AngleWeighting::Trapezoid;
+            auto range = std::minmax_element(angles.begin(), angles.end());
+            std::cout << "Angles: " << angles_path << ", " << *range.first << " to " << *range.second
+                      << " degrees, " << angle_weighting_name(opts.fbp.angle_weighting) << " weights\n";
+        }
+
+        // 输出网格：默认整幅 n_det x n_det，可指定 ROI 和像素尺寸
+        ReconGrid grid;
+        if (!opts.roi.empty() || opts.pixel_size != 1.0) {
+            grid = opts.roi.empty() ? ReconGrid::roi(0, 0, n_det, n_det, opts.pixel_size)
+                                    : ReconGrid::roi(opts.roi[0], opts.roi[1], opts.roi[2], opts.roi[3], opts.pixel_size);
+            std::cout << "Output grid: " << grid.nx << " x " << grid.ny << " pixels of " << grid.pixel
+                      << " detector pixels, first pixel at (" << grid.x0 << ", " << grid.y0 << ")\n";
+        }
+        grid = grid.resolved(n_det);
+
+        if (opts.stream_slices > 0) {
+            reconstruct_streaming(ds, n_slices, n_angles, n_det, angles, grid, opts);
+            return 0;
+        }
+
         size_t slice_size = size_t(n_angles) * n_det;
-        size_t recon_size = size_t(n_det) * n_det;
         size_t total_sino_size = n_slices * slice_size;
-        size_t total_recon_size = n_slices * recon_size;
         
         // ============================================================
         // Allocate memory buffers
         // ============================================================
         
         std::vector<float> sino_buffer(total_sino_size);
-        std::vector<float> recon_buffer(total_recon_size);
         
         // ============================================================
         // Read sinogram from HDF5
@@ -125,12 +547,17 @@ int main(int argc, char** argv) {
         H5::DataType t = ds.getDataType();
         
         if (t == H5::PredType::NATIVE_FLOAT) {
+            ProfileScope timer(Stage::Read);
             ds.read(sino_buffer.data(), H5::PredType::NATIVE_FLOAT);
         } else if (t == H5::PredType::NATIVE_DOUBLE) {
             // Read as double, then convert to float
             std::vector<double> tmp(total_sino_size);
-            ds.read(tmp.data(), H5::PredType::NATIVE_DOUBLE);
+            {
+                ProfileScope timer(Stage::Read);
+                ds.read(tmp.data(), H5::PredType::NATIVE_DOUBLE);
+            }
             
+            ProfileScope timer(Stage::Convert);
             #pragma omp parallel for
             for (size_t i = 0; i < total_sino_size; ++i) {
                 sino_buffer[i] = static_cast<float>(tmp[i]);
@@ -138,54 +565,145 @@ int main(int argc, char** argv) {
         } else {
             throw std::runtime_error("Unsupported data type");
         }
-        
-        // Generate uniformly spaced angles [0, 180) degrees
-        auto angles = generate_angles(n_angles);
+
+        // ============================================================
+        // Preview: reconstruct a downsampled volume instead
+        // ============================================================
+
+        if (opts.preview > 0) {
+            std::vector<float> coarse, coarse_angles;
+            downsample_sinogram(sino_buffer.data(), n_slices, n_angles, n_det, angles, opts.preview,
+                                coarse, coarse_angles, n_slices, n_det);
+            n_angles = int(coarse_angles.size());
+            sino_buffer.swap(coarse);
+            angles.swap(coarse_angles);
+            grid = ReconGrid().resolved(n_det);
+            std::cout << "Preview 1/" << opts.preview << ": [" << n_slices << " slices, "
+                      << n_angles << " angles, " << n_det << " detectors]\n";
+        }
+
+        size_t recon_size = size_t(grid.nx) * grid.ny;
+        size_t total_recon_size = n_slices * recon_size;
+        std::vector<float> recon_buffer(total_recon_size);
+
+        // ============================================================
+        // Benchmark mode: backprojection only
+        // ============================================================
+
+        if (opts.bench_reps > 0) {
+            std::cout << "\nBenchmarking backprojection (backend: " << backend_name(resolve_backend(opts.fbp.backend))
+                      << ", tile " << opts.fbp.tile_size << ", angle block " << opts.fbp.angle_block
+                      << ", slice batch " << opts.fbp.slice_batch
+                      << ", sinogram " << sino_precision_name(opts.fbp.sino_precision) << ")...\n";
+            double best_s = 1e30;
+            for (int rep = 0; rep < opts.bench_reps; ++rep) {
+                std::fill(recon_buffer.begin(), recon_buffer.end(), 0.0f);
+                BackprojectStats stats;
+                fbp_backproject_3d(sino_buffer.data(), recon_buffer.data(), n_slices, n_angles, n_det,
+                                   angles, opts.fbp, &stats);
+                best_s = std::min(best_s, stats.seconds);
+                std::cout << "  run " << rep << ": " << stats.seconds << " s, "
+                          << (double(total_recon_size) / stats.seconds / 1e6) << " Mvoxels/s, "
+                          << (stats.sino_bytes / stats.seconds / 1e9) << " GB/s sinogram traffic ("
+                          << (stats.sino_bytes / 1e9) << " GB)\n";
+            }
+            std::cout << "Best: " << best_s << " s, "
+                      << (double(total_recon_size) / best_s / 1e6) << " Mvoxels/s\n";
+            report_profile(opts, t_program, n_slices, n_angles, n_det, "FBP");
+            return 0;
+        }
         
         // ============================================================
         // Perform FBP reconstruction
         // ============================================================
         
-        std::cout << "\nStarting FBP reconstruction...\n";
+        const char* method = cone_beam ? "FDK" : opts.iterative ? iterative_method_name(opts.iter.method)
+                           : opts.live_block > 0 ? "Live FBP" : "FBP";
+        std::cout << "\nStarting " << method << " reconstruction (filter: "
+                  << filter_type_name(opts.fbp.filter)
+                  << ", backend: " << backend_name(resolve_backend(opts.fbp.backend)) << ")...\n";
         
+        // 滤波是原地进行的，校验用的 FP32 重建需要一份未滤波的副本
+        std::vector<float> validate_sino;
+        if (opts.validate_precision) validate_sino = sino_buffer;
+
+        std::vector<uint8_t> pixels;  // --fused-output: PNG slices quantized by the engine
+
         // Start timing
         auto t_start = std::chrono::high_resolution_clock::now();
         
-        fbp_reconstruct_3d(
-            sino_buffer.data(),   // Input: will be filtered in-place
-            recon_buffer.data(),  // Output: reconstructed volume
-            n_slices,
-            n_angles,
-            n_det,
-            angles
-        );
+        if (cone_beam) {
+            // 探测器行对应输出的 z 切片，投影按同样的 [行, 角度, 列] 布局读入
+            fdk_reconstruct_3d(sino_buffer.data(), recon_buffer.data(), n_slices, n_angles, n_det,
+                               angles, cone, opts.fbp);
+        } else if (opts.iterative) {
+            auto iter_stats = iterative_reconstruct_3d(sino_buffer.data(), recon_buffer.data(), n_slices,
+                                                       n_angles, n_det, angles, opts.iter, opts.fbp);
+            for (size_t it = 0; it < iter_stats.size(); ++it) {
+                std::cout << "  iteration " << (it + 1) << ": " << iter_stats[it].seconds
+                          << " s, relative residual " << iter_stats[it].residual << "\n";
+            }
+        } else if (opts.live_block > 0) {
+            reconstruct_live(sino_buffer, n_slices, n_angles, n_det, angles, grid, opts, recon_buffer);
+        } else if (opts.fused_output) {
+            fbp_reconstruct_quantized_3d(sino_buffer.data(), recon_buffer.data(), n_slices, n_angles, n_det,
+                                         angles, grid, fused_output(opts, n_slices, grid, pixels), opts.fbp);
+        } else {
+            fbp_reconstruct_roi_3d(
+                sino_buffer.data(),   // Input: will be filtered in-place
+                recon_buffer.data(),  // Output: reconstructed volume
+                n_slices,
+                n_angles,
+                n_det,
+                angles,
+                grid,
+                opts.fbp
+            );
+        }
         
         // End timing
         auto t_end = std::chrono::high_resolution_clock::now();
         auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
         auto duration_s = duration_ms / 1000.0;
         
-        std::cout << "FBP reconstruction completed in " << duration_s << " seconds\n";
+        std::cout << method << " reconstruction completed in " << duration_s << " seconds\n";
         std::cout << "Average time per slice: " << (duration_ms / double(n_slices)) << " ms\n";
+        std::cout << "Throughput: " << (double(total_recon_size) / std::max(duration_s, 1e-3) / 1e6)
+                  << " Mvoxels/s (slice batch " << opts.fbp.slice_batch << ")\n";
+
+        if (!validate_sino.empty()) {
+            FbpOptions ref_opts = opts.fbp;
+            ref_opts.sino_precision = SinoPrecision::F32;
+            std::vector<float> ref_buffer(total_recon_size);
+            auto t_ref = std::chrono::steady_clock::now();
+            // 参考重建不计入 profile
+            const bool profiling = profiling_flag().exchange(false);
+            fbp_reconstruct_roi_3d(validate_sino.data(), ref_buffer.data(), n_slices, n_angles, n_det, angles,
+                                   grid, ref_opts);
+            profiling_flag().store(profiling);
+            std::cout << "f32 reference reconstruction: "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - t_ref).count() << " seconds\n";
+            report_precision_error(ref_buffer, recon_buffer, opts.fbp.sino_precision);
+        }
         
         // ============================================================
         // Save results as PNG images
         // ============================================================
         
         std::cout << "\nSaving results...\n";
-        fs::create_directories("recon_out");
-        
-        for (int i = 0; i < n_slices; ++i) {
-            char filename[64];
-            
-            // Save reconstructed image
-            const float* recon_ptr = recon_buffer.data() + i * recon_size;
-            snprintf(filename, sizeof(filename), "recon_out/recon_%03d.png", i);
-            save_png(filename, recon_ptr, n_det, n_det);
-            
+        auto t_save = std::chrono::steady_clock::now();
+        VolumeWriter writer(opts.output, "recon_out", n_slices, grid.ny, grid.nx, opts.output_threads,
+                            2 * opts.output_threads, opts.png_bits);
+        if (opts.fused_output) {
+            writer.write_quantized(0, n_slices, std::move(pixels));
+        } else {
+            writer.write(0, n_slices, std::move(recon_buffer));
         }
-        
-        std::cout << "All results saved to recon_out/\n";
+        writer.finish();
+        std::cout << "All results saved to " << writer.path() << " (" << output_format_name(opts.output)
+                  << ") in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - t_save).count()
+                  << " seconds\n";
+        report_profile(opts, t_program, n_slices, n_angles, n_det, method);
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
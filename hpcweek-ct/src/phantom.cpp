@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "phantom.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+PhantomKind parse_phantom_kind(const std::string& name) {
+    if (name == "shepp-logan" || name == "shepplogan") return PhantomKind::SheppLogan;
+    if (name == "ellipses" || name == "random")      return PhantomKind::Ellipses;
+    throw std::invalid_argument("Unknown phantom: " + name + " (expected shepp-logan, ellipses)");
+}
+
+const char* phantom_kind_name(PhantomKind kind) {
+    switch (kind) {
+        case PhantomKind::SheppLogan: return "shepp-logan";
+        case PhantomKind::Ellipses:   return "ellipses";
+    }
+    return "unknown";
+}
+
+/**
+ * Uniform [lo, hi) from the raw generator output
+ *
+ * std::uniform_real_distribution is implementation-defined, mt19937 itself
+ * is not, so the same seed gives the same phantom with every standard library.
+ */
+static double uniform(std::mt19937& rng, double lo, double hi) {
+    return lo + (hi - lo) * (double(rng() >> 8) * (1.0 / 16777216.0));
+}
+
+std::vector<Ellipsoid> phantom_ellipsoids(PhantomKind kind, int count, uint32_t seed) {
+    if (kind == PhantomKind::SheppLogan) {
+        //  rho     a       b      c      x0      y0      z0    phi
+        return {
+            { 1.0, 0.6900, 0.920, 0.810,  0.00,  0.0000,  0.00,   0},
+            {-0.8, 0.6624, 0.874, 0.780,  0.00, -0.0184,  0.00,   0},
+            {-0.2, 0.1100, 0.310, 0.220,  0.22,  0.0000,  0.00, -18},
+            {-0.2, 0.1600, 0.410, 0.280, -0.22,  0.0000,  0.00,  18},
+            { 0.1, 0.2100, 0.250, 0.410,  0.00,  0.3500, -0.15,   0},
+            { 0.1, 0.0460, 0.046, 0.050,  0.00,  0.1000,  0.25,   0},
+            { 0.1, 0.0460, 0.046, 0.050,  0.00, -0.1000,  0.25,   0},
+            { 0.1, 0.0460, 0.023, 0.050, -0.08, -0.6050,  0.00,   0},
+            { 0.1, 0.0230, 0.023, 0.020,  0.00, -0.6060,  0.00,   0},
+            { 0.1, 0.0230, 0.046, 0.020,  0.06, -0.6050,  0.00,   0},
+        };
+    }
+
+    if (count < 0) throw std::invalid_argument("Phantom ellipse count must be >= 0");
+    std::mt19937 rng(seed);
+    std::vector<Ellipsoid> phantom;
+    // 外层均匀体，内部椭球都放在它里面
+    phantom.push_back({1.0, uniform(rng, 0.80, 0.90), uniform(rng, 0.70, 0.85), 1.0,
+                       0.0, 0.0, 0.0, uniform(rng, -15, 15)});
+    for (int i = 0; i < count; ++i) {
+        Ellipsoid e;
+        e.a = uniform(rng, 0.04, 0.25);
+        e.b = uniform(rng, 0.04, 0.25);
+        e.c = uniform(rng, 0.20, 0.80);
+        // 圆心在半径 0.65 - max(a, b) 的圆盘内均匀分布，保证不越出外层
+        const double r = (0.65 - std::max(e.a, e.b)) * std::sqrt(uniform(rng, 0, 1));
+        const double t = uniform(rng, 0, 2 * PI);
+        e.x0 = r * std::cos(t);
+        e.y0 = r * std::sin(t);
+        e.z0 = uniform(rng, -0.3, 0.3);
+        e.phi_deg = uniform(rng, 0, 180);
+        e.rho = uniform(rng, 0.1, 0.5) * (rng() & 1 ? 1.0 : -1.0);
+        phantom.push_back(e);
+    }
+    return phantom;
+}
+
+double phantom_slice_z(int slice, int n_slices) {
+    return n_slices > 1 ? -0.25 + 0.5 * slice / (n_slices - 1) : 0.0;
+}
+
+/**
+ * Cross-section of the phantom at z: ellipsoid semi-axes scaled by
+ * sqrt(1 - ((z - z0) / c)^2), ellipsoids not cut by the plane dropped
+ */
+struct Ellipse {
+    double rho, a, b, x0, y0, cos_p, sin_p;
+};
+
+static std::vector<Ellipse> slice_ellipses(const std::vector<Ellipsoid>& phantom, double z) {
+    std::vector<Ellipse> out;
+    for (const Ellipsoid& e : phantom) {
+        const double dz = (z - e.z0) / e.c;
+        if (dz * dz >= 1.0) continue;
+        const double k = std::sqrt(1.0 - dz * dz);
+        const double phi = e.phi_deg * PI / 180.0;
+        out.push_back({e.rho, e.a * k, e.b * k, e.x0, e.y0, std::cos(phi), std::sin(phi)});
+    }
+    return out;
+}
+
+void rasterize_phantom(const std::vector<Ellipsoid>& phantom, double z, int n_det, float* out, int ss) {
+    const std::vector<Ellipse> ellipses = slice_ellipses(phantom, z);
+    const double c = (n_det - 1) * 0.5;
+    const double inv_r = 2.0 / n_det;  // 像素 -> 归一化坐标
+    const double inv_samples = 1.0 / (double(ss) * ss);
+
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < n_det; ++y) {
+        for (int x = 0; x < n_det; ++x) {
+            double sum = 0;
+            for (int sy = 0; sy < ss; ++sy) {
+                const double Y = (y - c + (sy + 0.5) / ss - 0.5) * inv_r;
+                for (int sx = 0; sx < ss; ++sx) {
+                    const double X = (x - c + (sx + 0.5) / ss - 0.5) * inv_r;
+                    for (const Ellipse& e : ellipses) {
+                        const double px = X - e.x0, py = Y - e.y0;
+                        const double u = (px * e.cos_p + py * e.sin_p) / e.a;
+                        const double v = (-px * e.sin_p + py * e.cos_p) / e.b;
+                        if (u * u + v * v <= 1.0) sum += e.rho;
+                    }
+                }
+            }
+            out[size_t(y) * n_det + x] = float(sum * inv_samples);
+        }
+    }
+}
+
+void project_phantom(const std::vector<Ellipsoid>& phantom, double z, const std::vector<float>& angles_deg,
+                     int n_det, float* out) {
+    const std::vector<Ellipse> ellipses = slice_ellipses(phantom, z);
+    const int n_angles = int(angles_deg.size());
+    const double c = (n_det - 1) * 0.5;
+    const double r = n_det * 0.5;  // 单位圆半径（像素）
+
+    #pragma omp parallel for schedule(static)
+    for (int ai = 0; ai < n_angles; ++ai) {
+        const double theta = double(angles_deg[ai]) * PI / 180.0;
+        const double ct = std::cos(theta), st = std::sin(theta);
+        float* row = out + size_t(ai) * n_det;
+        std::fill(row, row + n_det, 0.0f);
+        for (const Ellipse& e : ellipses) {
+            // 射线法向在椭圆自身坐标系中的方向
+            const double cp = ct * e.cos_p + st * e.sin_p;
+            const double sp = st * e.cos_p - ct * e.sin_p;
+            const double a2 = e.a * e.a * cp * cp + e.b * e.b * sp * sp;
+            const double shift = e.x0 * ct + e.y0 * st;
+            const double k = 2.0 * e.rho * e.a * e.b / a2 * r;  // 弦长换算成像素
+            for (int j = 0; j < n_det; ++j) {
+                const double s = (j - c) / r - shift;
+                const double d = a2 - s * s;
+                if (d > 0) row[j] += float(k * std::sqrt(d));
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Analytic test phantoms with exact parallel-beam projections
+ *
+ * A phantom is a sum of constant-density ellipsoids in normalized
+ * coordinates: the unit disk of a slice fills the n_det x n_det image
+ * (radius n_det / 2 pixels) and slices sample z in [-1, 1]. Ellipsoids are
+ * rotated about z only, so every slice is an exact sum of ellipses whose
+ * line integrals have a closed form.
+ */
+enum class PhantomKind {
+    SheppLogan,  // 3-D modified Shepp-Logan (Toft contrast), tilts about x / y dropped
+    Ellipses,    // Random ellipsoids inside a unit-density body
+};
+
+/**
+ * @throws std::invalid_argument for names other than shepp-logan, ellipses
+ */
+PhantomKind parse_phantom_kind(const std::string& name);
+const char* phantom_kind_name(PhantomKind kind);
+
+struct Ellipsoid {
+    double rho;         // Density added inside the ellipsoid
+    double a, b, c;     // Semi-axes along x, y, z (before rotation)
+    double x0, y0, z0;  // Center
+    double phi_deg;     // Rotation about z, counter-clockwise
+};
+
+/**
+ * Ellipsoids of a phantom
+ *
+ * @param count  Number of random inner ellipsoids (Ellipses only)
+ * @param seed   Random seed (Ellipses only); the same seed gives the same
+ *               phantom on every platform
+ */
+std::vector<Ellipsoid> phantom_ellipsoids(PhantomKind kind, int count = 12, uint32_t seed = 1);
+
+/**
+ * Slice positions used for an n_slices volume: evenly spaced over the
+ * central part of [-1, 1] where the phantoms have structure
+ */
+double phantom_slice_z(int slice, int n_slices);
+
+/**
+ * Ground-truth image of the slice at z
+ *
+ * Each pixel is the mean of ss x ss point samples, i.e. approximately the
+ * pixel-area average of the density.
+ *
+ * @param out  Image [n_det, n_det], row y / column x as in the reconstruction
+ */
+void rasterize_phantom(const std::vector<Ellipsoid>& phantom, double z, int n_det, float* out, int ss = 4);
+
+/**
+ * Exact sinogram of the slice at z for the reconstruction geometry
+ * (detector bin j at t = j - (n_det - 1) / 2 pixels, angle theta measured
+ * like make_geometry), in density x pixel units
+ *
+ * @param out  Sinogram [n_angles, n_det]
+ */
+void project_phantom(const std::vector<Ellipsoid>& phantom, double z, const std::vector<float>& angles_deg,
+                     int n_det, float* out);
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "profiler.h"
+
+namespace {
+
+constexpr int N_STAGES = int(Stage::Count);
+
+const char* const PERF_NAMES[PERF_COUNTERS] = {"cycles", "instructions", "cache_references", "cache_misses"};
+
+bool g_perf_requested = false;
+
+}  // namespace
+
+struct ThreadProfile {
+    int id = 0;
+    double seconds[N_STAGES] = {};
+    uint64_t calls[N_STAGES] = {};
+
+    // perf 计数器组; -1 = 未打开, -2 = 打开失败, 不再重试
+    int perf_leader = -1;
+    int perf_fds[PERF_COUNTERS] = {-1, -1, -1, -1};
+    uint64_t perf_totals[PERF_COUNTERS] = {};
+    uint64_t perf_scopes = 0;
+};
+
+namespace {
+
+// 槽位归注册表所有, 线程退出后报告仍可读取
+std::mutex& registry_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<std::unique_ptr<ThreadProfile>>& registry() {
+    static std::vector<std::unique_ptr<ThreadProfile>> slots;
+    return slots;
+}
+
+#ifdef __linux__
+int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // pid = 0, cpu = -1: 只统计调用线程, 不限 CPU
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+bool open_counters(ThreadProfile& slot) {
+    static const uint64_t configs[PERF_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+    for (int i = 0; i < PERF_COUNTERS; ++i) {
+        slot.perf_fds[i] = open_counter(configs[i], i == 0 ? -1 : slot.perf_fds[0]);
+        if (slot.perf_fds[i] < 0) {
+            for (int j = 0; j < i; ++j) close(slot.perf_fds[j]);
+            std::fill(slot.perf_fds, slot.perf_fds + PERF_COUNTERS, -1);
+            slot.perf_leader = -2;
+            return false;
+        }
+    }
+    slot.perf_leader = slot.perf_fds[0];
+    ioctl(slot.perf_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(slot.perf_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+#endif
+
+void json_string(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        switch (c) {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    os << buf;
+                } else {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+}
+
+struct StageTotals {
+    double seconds[N_STAGES] = {};
+    double max_thread[N_STAGES] = {};
+    uint64_t calls[N_STAGES] = {};
+    uint64_t perf[PERF_COUNTERS] = {};
+    uint64_t perf_scopes = 0;
+    int perf_threads = 0;
+};
+
+StageTotals collect() {
+    StageTotals t;
+    for (const auto& slot : registry()) {
+        for (int s = 0; s < N_STAGES; ++s) {
+            t.seconds[s] += slot->seconds[s];
+            t.max_thread[s] = std::max(t.max_thread[s], slot->seconds[s]);
+            t.calls[s] += slot->calls[s];
+        }
+        if (slot->perf_leader >= 0) {
+            ++t.perf_threads;
+            t.perf_scopes += slot->perf_scopes;
+            for (int i = 0; i < PERF_COUNTERS; ++i) t.perf[i] += slot->perf_totals[i];
+        }
+    }
+    return t;
+}
+
+}  // namespace
+
+const char* stage_name(Stage stage) {
+    switch (stage) {
+        case Stage::Read: return "read";
+        case Stage::Convert: return "convert";
+        case Stage::Filter: return "filter";
+        case Stage::Encode: return "encode";
+        case Stage::Backproject: return "backproject";
+        case Stage::Scale: return "scale";
+        case Stage::Write: return "write";
+        default: return "?";
+    }
+}
+
+ThreadProfile& thread_profile() {
+    thread_local ThreadProfile* slot = nullptr;
+    if (!slot) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().push_back(std::make_unique<ThreadProfile>());
+        slot = registry().back().get();
+        slot->id = int(registry().size()) - 1;
+    }
+    return *slot;
+}
+
+void profile_add(ThreadProfile& slot, Stage stage, double seconds) {
+    slot.seconds[int(stage)] += seconds;
+    ++slot.calls[int(stage)];
+}
+
+bool perf_read(ThreadProfile& slot, uint64_t* values) {
+#ifdef __linux__
+    if (!g_perf_requested || slot.perf_leader == -2) return false;
+    if (slot.perf_leader == -1 && !open_counters(slot)) return false;
+    // PERF_FORMAT_GROUP: { nr, value[nr] }
+    uint64_t buf[1 + PERF_COUNTERS];
+    if (read(slot.perf_leader, buf, sizeof(buf)) != ssize_t(sizeof(buf)) || buf[0] != PERF_COUNTERS) return false;
+    std::memcpy(values, buf + 1, sizeof(uint64_t) * PERF_COUNTERS);
+    return true;
+#else
+    (void)slot;
+    (void)values;
+    return false;
+#endif
+}
+
+void perf_accumulate(ThreadProfile& slot, const uint64_t* begin) {
+    uint64_t now[PERF_COUNTERS];
+    if (!perf_read(slot, now)) return;
+    for (int i = 0; i < PERF_COUNTERS; ++i) slot.perf_totals[i] += now[i] - begin[i];
+    ++slot.perf_scopes;
+}
+
+void profiler_enable(bool perf_counters) {
+    g_perf_requested = perf_counters;
+    profiling_flag().store(true, std::memory_order_relaxed);
+}
+
+void print_profile_summary(std::ostream& os, double wall_seconds) {
+    StageTotals t;
+    size_t n_threads;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        t = collect();
+        n_threads = registry().size();
+    }
+
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << "Profile (" << n_threads << " threads, wall " << std::fixed << std::setprecision(3) << wall_seconds << " s)\n";
+    os << "  " << std::left << std::setw(12) << "stage" << std::right
+       << std::setw(10) << "calls" << std::setw(12) << "thread s"
+       << std::setw(12) << "max thr s" << std::setw(9) << "wall %" << "\n";
+    for (int s = 0; s < N_STAGES; ++s) {
+        if (t.calls[s] == 0) continue;
+        // 最慢线程时间 / 墙钟时间, 近似该阶段在关键路径上的占比
+        double share = wall_seconds > 0 ? 100.0 * t.max_thread[s] / wall_seconds : 0.0;
+        os << "  " << std::left << std::setw(12) << stage_name(Stage(s)) << std::right
+           << std::setw(10) << t.calls[s]
+           << std::setw(12) << std::setprecision(4) << t.seconds[s]
+           << std::setw(12) << t.max_thread[s]
+           << std::setw(8) << std::setprecision(1) << share << "%\n";
+    }
+    if (g_perf_requested) {
+        if (t.perf_threads == 0) {
+            os << "  perf counters unavailable (perf_event_open refused)\n";
+        } else {
+            os << "  backproject counters (" << t.perf_threads << " threads):";
+            for (int i = 0; i < PERF_COUNTERS; ++i) os << " " << PERF_NAMES[i] << "=" << t.perf[i];
+            if (t.perf[0] > 0) os << " ipc=" << std::setprecision(2) << double(t.perf[1]) / double(t.perf[0]);
+            os << "\n";
+        }
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void write_profile_json(const std::string& path, double wall_seconds,
+    const std::vector<std::pair<std::string, std::string>>& config) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write profile " + path);
+    out << std::setprecision(9);
+
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    StageTotals t = collect();
+
+    out << "{\n  \"version\": 1,\n  \"wall_seconds\": " << wall_seconds << ",\n  \"config\": {";
+    for (size_t i = 0; i < config.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ");
+        json_string(out, config[i].first);
+        out << ": ";
+        json_string(out, config[i].second);
+    }
+    out << (config.empty() ? "},\n" : "\n  },\n");
+
+    out << "  \"stages\": {";
+    bool first = true;
+    for (int s = 0; s < N_STAGES; ++s) {
+        if (t.calls[s] == 0) continue;
+        out << (first ? "\n    " : ",\n    ") << '"' << stage_name(Stage(s)) << "\": {\"calls\": " << t.calls[s]
+            << ", \"thread_seconds\": " << t.seconds[s] << ", \"max_thread_seconds\": " << t.max_thread[s] << "}";
+        first = false;
+    }
+    out << (first ? "},\n" : "\n  },\n");
+
+    out << "  \"threads\": [";
+    const auto& slots = registry();
+    for (size_t i = 0; i < slots.size(); ++i) {
+        const ThreadProfile& slot = *slots[i];
+        out << (i ? ",\n    " : "\n    ") << "{\"id\": " << slot.id << ", \"seconds\": {";
+        bool any = false;
+        for (int s = 0; s < N_STAGES; ++s) {
+            if (slot.calls[s] == 0) continue;
+            out << (any ? ", " : "") << '"' << stage_name(Stage(s)) << "\": " << slot.seconds[s];
+            any = true;
+        }
+        out << "}";
+        if (slot.perf_leader >= 0) {
+            out << ", \"counters\": {";
+            for (int c = 0; c < PERF_COUNTERS; ++c) out << (c ? ", " : "") << '"' << PERF_NAMES[c] << "\": " << slot.perf_totals[c];
+            out << "}";
+        }
+        out << "}";
+    }
+    out << (slots.empty() ? "],\n" : "\n  ],\n");
+
+    out << "  \"counters\": {\"requested\": " << (g_perf_requested ? "true" : "false")
+        << ", \"available\": " << (t.perf_threads > 0 ? "true" : "false");
+    if (t.perf_threads > 0) {
+        out << ", \"stage\": \"backproject\", \"scopes\": " << t.perf_scopes;
+        for (int c = 0; c < PERF_COUNTERS; ++c) out << ", \"" << PERF_NAMES[c] << "\": " << t.perf[c];
+    }
+    out << "}\n}\n";
+    if (!out) throw std::runtime_error("Cannot write profile " + path);
+}
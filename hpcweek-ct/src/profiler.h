@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Pipeline stages timed by the profiler
+ *
+ * Stages are exclusive: Backproject covers the detector span copy / decode
+ * and the accumulation, Scale the epilogue that follows it (normalization
+ * when it is not folded into the filter, min / max, quantization).
+ */
+enum class Stage {
+    Read,         // HDF5 read
+    Convert,      // double -> float conversion of the input
+    Filter,       // Ramp filter (FFT, multiply, IFFT, angle weights)
+    Encode,       // 16-bit sinogram encoding (--sino-precision)
+    Backproject,
+    Scale,
+    Write,        // Output normalization, encoding and file write
+    Count
+};
+
+/** Name of a stage as used in the report */
+const char* stage_name(Stage stage);
+
+/**
+ * Global on/off switch; off (the default) reduces every scope to one
+ * relaxed atomic load
+ */
+inline std::atomic<bool>& profiling_flag() {
+    static std::atomic<bool> enabled{false};
+    return enabled;
+}
+
+/**
+ * Per-thread accumulators, registered on first use by each thread
+ */
+struct ThreadProfile;
+
+ThreadProfile& thread_profile();
+void profile_add(ThreadProfile& slot, Stage stage, double seconds);
+
+/**
+ * Hardware counters of the calling thread (perf_event_open, Linux)
+ *
+ * @param values  Receives the current counter values
+ * @return false if counters are disabled or unavailable on this thread
+ */
+bool perf_read(ThreadProfile& slot, uint64_t* values);
+
+/** Add the counter deltas since `begin` (from perf_read) to the thread */
+void perf_accumulate(ThreadProfile& slot, const uint64_t* begin);
+
+constexpr int PERF_COUNTERS = 4;  // cycles, instructions, cache references, cache misses
+
+/**
+ * Times the enclosing block as one call of a stage on the current thread
+ *
+ * @param counters  Also accumulate hardware counter deltas (backprojection)
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(Stage stage, bool counters = false)
+        : stage_(stage), active_(profiling_flag().load(std::memory_order_relaxed)) {
+        if (!active_) return;
+        slot_ = &thread_profile();
+        counting_ = counters && perf_read(*slot_, perf_begin_);
+        t0_ = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() { stop(); }
+
+    /** End the timed region before the end of the block */
+    void stop() {
+        if (!active_) return;
+        active_ = false;
+        profile_add(*slot_, stage_, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count());
+        if (counting_) perf_accumulate(*slot_, perf_begin_);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Stage stage_;
+    bool active_;
+    bool counting_ = false;
+    ThreadProfile* slot_ = nullptr;
+    std::chrono::steady_clock::time_point t0_;
+    uint64_t perf_begin_[PERF_COUNTERS];
+};
+
+/**
+ * Start collecting (call before the threads being profiled start work)
+ *
+ * @param perf_counters  Open hardware counters for backprojection scopes;
+ *                       silently unavailable if the kernel refuses
+ *                       (perf_event_paranoid, containers, non-Linux)
+ */
+void profiler_enable(bool perf_counters);
+
+/**
+ * Print a per-stage table (calls, summed thread time, slowest thread,
+ * share of wall time) and the counter totals
+ */
+void print_profile_summary(std::ostream& os, double wall_seconds);
+
+/**
+ * Write the profile as JSON: config key/values, per-stage totals,
+ * per-thread stage times and counters
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_profile_json(const std::string& path, double wall_seconds,
+    const std::vector<std::pair<std::string, std::string>>& config);
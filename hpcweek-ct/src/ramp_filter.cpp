@@ -0,0 +1,124 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <cmath>
+#include <algorithm>
+
+#include "ramp_filter.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+/**
+ * Generate Ramp filter kernel in spatial domain
+ * 
+ * @param len  Kernel length (will be made odd if even)
+ * @param d    Detector pixel spacing (default 1.0)
+ * @return     Symmetric filter kernel centered at middle
+ */
+static std::vector<float> ramp_kernel(int len, float d = 1.0f) {
+    if (len % 2 == 0) len += 1;  // Ensure odd length for symmetry
+    int K = len / 2;  // Center index
+    
+    std::vector<float> h(len, 0.0f);
+    
+    // Center value
+    h[K] = 1.0f / (4.0f * d * d);
+    
+    // Symmetric side lobes (only odd positions have non-zero values)
+    for (int n = 1; n <= K; ++n) {
+        if (n % 2 == 1) {
+            float val = -1.0f / (float(PI) * float(PI) * n * n * d * d);
+            h[K + n] = val;
+            h[K - n] = val;
+        }
+    }
+    
+    return h;
+}
+
+/**
+ * Apodization window value at normalized frequency f in [0, 0.5]
+ */
+static double filter_window(FilterType type, double f) {
+    switch (type) {
+        case FilterType::RamLak:
+            return 1.0;
+        case FilterType::SheppLogan:
+            return (f == 0.0) ? 1.0 : std::sin(PI * f) / (PI * f);
+        case FilterType::Cosine:
+            return std::cos(PI * f);
+        case FilterType::Hamming:
+            return 0.54 + 0.46 * std::cos(2.0 * PI * f);
+        case FilterType::Hann:
+            return 0.5 + 0.5 * std::cos(2.0 * PI * f);
+    }
+    return 1.0;
+}
+
+RampFilter::RampFilter(int n_det_, float d, FilterType type)
+    : n_det(n_det_), n_fft(next_pow2(2 * n_det_ - 1)), plan(n_fft), H(n_fft) {
+    auto kernel = ramp_kernel(n_det | 1, d);
+    const int K = int(kernel.size() / 2);
+
+    std::vector<std::complex<float>> spec(n_fft, 0.0f);
+    spec[0] = kernel[K];
+    for (int k = 1; k <= K; ++k) {
+        spec[k] = kernel[K + k];
+        spec[n_fft - k] = kernel[K - k];
+    }
+    plan.forward(spec.data());
+
+    const float inv_n = 1.0f / float(n_fft);
+    for (int k = 0; k < n_fft; ++k) {
+        double f = double(std::min(k, n_fft - k)) / n_fft;
+        H[k] = float(spec[k].real() * filter_window(type, f)) * inv_n;
+    }
+}
+
+void filter_row_pair(float* __restrict row_a, float* __restrict row_b,
+    const RampFilter& filter, std::complex<float>* __restrict work,
+    float weight_a, float weight_b) {
+    const int n_det = filter.n_det;
+    const int n_fft = filter.n_fft;
+    const float* __restrict H = filter.H.data();
+
+    if (row_b) {
+        for (int x = 0; x < n_det; ++x) work[x] = std::complex<float>(row_a[x], row_b[x]);
+    } else {
+        for (int x = 0; x < n_det; ++x) work[x] = std::complex<float>(row_a[x], 0.0f);
+    }
+    std::fill(work + n_det, work + n_fft, std::complex<float>(0.0f, 0.0f));
+
+    filter.plan.forward(work);
+    for (int k = 0; k < n_fft; ++k) work[k] *= H[k];
+    filter.plan.inverse(work);
+
+    // 角度权重在写回时顺带乘上，不多一趟遍历
+    if (weight_a == 1.0f) {
+        for (int x = 0; x < n_det; ++x) row_a[x] = work[x].real();
+    } else {
+        for (int x = 0; x < n_det; ++x) row_a[x] = work[x].real() * weight_a;
+    }
+    if (row_b) {
+        if (weight_b == 1.0f) {
+            for (int x = 0; x < n_det; ++x) row_b[x] = work[x].imag();
+        } else {
+            for (int x = 0; x < n_det; ++x) row_b[x] = work[x].imag() * weight_b;
+        }
+    }
+}
+
+void filter_projections(float* __restrict sino, int n_rows,
+    const RampFilter& filter, std::complex<float>* __restrict work,
+    const float* angle_weights, int n_angles) {
+    const int n_det = filter.n_det;
+    for (int a = 0; a < n_rows; a += 2) {
+        float* row_a = sino + size_t(a) * n_det;
+        float* row_b = (a + 1 < n_rows) ? row_a + n_det : nullptr;
+        if (angle_weights) {
+            filter_row_pair(row_a, row_b, filter, work, angle_weights[a % n_angles],
+                            angle_weights[(a + 1) % n_angles]);
+        } else {
+            filter_row_pair(row_a, row_b, filter, work);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "sino_codec.h"
+
+SinoPrecision parse_sino_precision(const std::string& name) {
+    if (name == "f32" || name == "fp32")      return SinoPrecision::F32;
+    if (name == "f16" || name == "fp16")      return SinoPrecision::F16;
+    if (name == "bf16")                       return SinoPrecision::BF16;
+    if (name == "fixed16" || name == "int16") return SinoPrecision::Fixed16;
+    throw std::invalid_argument("Unknown sinogram precision: " + name);
+}
+
+const char* sino_precision_name(SinoPrecision precision) {
+    switch (precision) {
+        case SinoPrecision::F32:     return "f32";
+        case SinoPrecision::F16:     return "f16";
+        case SinoPrecision::BF16:    return "bf16";
+        case SinoPrecision::Fixed16: return "fixed16";
+    }
+    return "unknown";
+}
+
+float encode_sino_row(const float* __restrict src, int n, SinoPrecision precision,
+    uint16_t* __restrict dst) {
+    float peak = 0.0f;
+    #pragma omp simd reduction(max:peak)
+    for (int i = 0; i < n; ++i) peak = std::max(peak, std::fabs(src[i]));
+
+    // 全零行：scale 为 0，样本写 0
+    const float target = precision == SinoPrecision::Fixed16 ? 32767.0f : 1.0f;
+    const float inv = peak > 0 ? target / peak : 0.0f;
+
+    switch (precision) {
+        case SinoPrecision::F16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) dst[i] = float_to_half(src[i] * inv);
+            break;
+        case SinoPrecision::BF16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) dst[i] = float_to_bf16(src[i] * inv);
+            break;
+        case SinoPrecision::Fixed16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) {
+                // |v| <= 32767，加减 0.5 后向零截断即四舍五入
+                const float v = src[i] * inv;
+                dst[i] = uint16_t(int16_t(int(v + std::copysign(0.5f, v))));
+            }
+            break;
+        case SinoPrecision::F32:
+            throw std::invalid_argument("encode_sino_row: f32 rows are not encoded");
+    }
+    return peak / target;
+}
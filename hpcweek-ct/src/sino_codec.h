@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "fbp.h"
+
+/**
+ * 16-bit storage of filtered sinogram rows
+ *
+ * Every detector row is stored as n_det 16-bit samples plus one float scale,
+ * value = decode(sample) * scale. The scale normalizes the row so its largest
+ * magnitude maps to 1 (FP16, BF16) or to 32767 (Fixed16); FP16 therefore
+ * never overflows and Fixed16 uses its full range on every row.
+ *
+ * The conversions are branch-free integer code so the row loops vectorize on
+ * every backend and need no F16C / FP16 instruction set extensions.
+ */
+
+static inline uint32_t float_as_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bits_as_float(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/**
+ * IEEE binary16, round to nearest even, saturating at 65504
+ */
+static inline uint16_t float_to_half(float x) {
+    uint32_t f = float_as_bits(x);
+    const uint32_t sign = (f >> 16) & 0x8000u;
+    f &= 0x7fffffffu;
+    f = f < 0x477fe000u ? f : 0x477fe000u;
+    // 次正规数：加 0.5 后 float 的 ulp 正好是 2^-24，由硬件完成舍入
+    const uint32_t sub = float_as_bits(bits_as_float(f) + 0.5f) - 0x3f000000u;
+    // 规格化数：指数重新偏置 (15 - 127)，尾数截到 10 位并就近偶数舍入
+    const uint32_t norm = (f + 0xc8000fffu + ((f >> 13) & 1u)) >> 13;
+    return uint16_t(sign | (f < 0x38800000u ? sub : norm));
+}
+
+static inline float half_to_float(uint16_t h) {
+    const uint32_t a = uint32_t(h & 0x7fffu) << 13;
+    const uint32_t norm = a + (112u << 23);
+    // 次正规数用 2^-14 + m*2^-24 减去 2^-14 得到，不产生 float 非规格化数
+    const uint32_t sub = float_as_bits(bits_as_float(a + (113u << 23)) - 0x1p-14f);
+    const uint32_t mask = (h & 0x7c00u) ? 0xffffffffu : 0u;
+    return bits_as_float(((norm & mask) | (sub & ~mask)) | (uint32_t(h & 0x8000u) << 16));
+}
+
+/**
+ * bfloat16 (upper half of a float), round to nearest even
+ */
+static inline uint16_t float_to_bf16(float x) {
+    const uint32_t f = float_as_bits(x);
+    return uint16_t((f + 0x7fffu + ((f >> 16) & 1u)) >> 16);
+}
+
+static inline float bf16_to_float(uint16_t h) {
+    return bits_as_float(uint32_t(h) << 16);
+}
+
+/**
+ * Encode one detector row
+ *
+ * @param precision  F16, BF16 or Fixed16
+ * @return           Row scale to pass to decode_sino_row
+ */
+float encode_sino_row(const float* src, int n, SinoPrecision precision, uint16_t* dst);
+
+/**
+ * Decode samples [0, n) of a row encoded with encode_sino_row
+ *
+ * dst[i] = value(src[i]) * scale; accumulation downstream stays FP32.
+ */
+static inline void decode_sino_row(const uint16_t* __restrict src, int n, float scale,
+    SinoPrecision precision, float* __restrict dst) {
+    switch (precision) {
+        case SinoPrecision::F16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) dst[i] = half_to_float(src[i]) * scale;
+            break;
+        case SinoPrecision::BF16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) dst[i] = bf16_to_float(src[i]) * scale;
+            break;
+        case SinoPrecision::Fixed16:
+            #pragma omp simd
+            for (int i = 0; i < n; ++i) dst[i] = float(int16_t(src[i])) * scale;
+            break;
+        case SinoPrecision::F32:
+            break;
+    }
+}
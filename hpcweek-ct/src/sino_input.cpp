@@ -0,0 +1,49 @@
+#include <stdexcept>
+
+#include "sino_input.h"
+
+std::vector<hsize_t> get_shape(const H5::DataSet& ds) {
+    H5::DataSpace sp = ds.getSpace();
+    int nd = sp.getSimpleExtentNdims();
+    std::vector<hsize_t> dims(nd);
+    sp.getSimpleExtentDims(dims.data(), nullptr);
+    return dims;
+}
+
+std::vector<float> generate_angles(int n_angles, float range_deg) {
+    std::vector<float> angles(n_angles);
+    for (int i = 0; i < n_angles; ++i) {
+        angles[i] = range_deg * i / n_angles;
+    }
+    return angles;
+}
+
+std::vector<float> read_angles(const H5::H5File& f, const std::string& path, int n_angles) {
+    if (!f.nameExists(path)) throw std::runtime_error("Angle dataset " + path + " not found in file");
+    H5::DataSet ds = f.openDataSet(path);
+    std::vector<hsize_t> shape = get_shape(ds);
+    if (shape.size() != 1 || int(shape[0]) != n_angles) {
+        throw std::runtime_error("Angle dataset " + path + " must be 1-D with " + std::to_string(n_angles) + " values");
+    }
+    std::vector<double> values(n_angles);
+    ds.read(values.data(), H5::PredType::NATIVE_DOUBLE);
+
+    double to_deg = 1.0;
+    if (ds.attrExists("units")) {
+        H5::Attribute attr = ds.openAttribute("units");
+        std::string units;
+        attr.read(attr.getStrType(), units);
+        if (units.rfind("rad", 0) == 0) to_deg = 180.0 / 3.14159265358979323846;
+    }
+    std::vector<float> angles(n_angles);
+    for (int i = 0; i < n_angles; ++i) angles[i] = float(values[i] * to_deg);
+    return angles;
+}
+
+std::vector<float> load_angles(const H5::H5File& f, const std::string& path, int n_angles,
+                               float range_deg, std::string& source) {
+    source = path;
+    if (source.empty() && f.nameExists("/angles")) source = "/angles";
+    if (source.empty()) return generate_angles(n_angles, range_deg);
+    return read_angles(f, source, n_angles);
+}
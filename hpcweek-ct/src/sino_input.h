@@ -0,0 +1,34 @@
+#pragma once
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+
+/**
+ * Dimensions of a dataset
+ */
+std::vector<hsize_t> get_shape(const H5::DataSet& ds);
+
+/**
+ * Uniformly spaced angles over [0, range_deg)
+ */
+std::vector<float> generate_angles(int n_angles, float range_deg = 180.0f);
+
+/**
+ * Projection angles stored in the file
+ *
+ * A 1-D dataset with one value per angle, in any order. Values are degrees
+ * unless the dataset has a string attribute "units" starting with "rad".
+ *
+ * @throws std::runtime_error if the dataset is missing or has the wrong size
+ */
+std::vector<float> read_angles(const H5::H5File& f, const std::string& path, int n_angles);
+
+/**
+ * Angles of a scan: the dataset at path, or /angles if path is empty and the
+ * file has one, else uniform over [0, range_deg)
+ *
+ * @param source  Receives the dataset path, or "" for generated angles
+ */
+std::vector<float> load_angles(const H5::H5File& f, const std::string& path, int n_angles,
+                               float range_deg, std::string& source);
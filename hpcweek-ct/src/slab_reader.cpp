@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "hdf5_lock.h"
+#include "profiler.h"
+#include "slab_reader.h"
+
+SlabReader::SlabReader(const H5::DataSet& ds, int slab_slices, int depth)
+    : ds_(ds), slab_slices_(std::max(slab_slices, 1)),
+      free_(std::max(depth, 2)), ready_(std::max(depth, 2)) {
+    {
+        std::lock_guard<std::mutex> lock(hdf5_mutex());
+        H5::DataSpace sp = ds_.getSpace();
+        if (sp.getSimpleExtentNdims() != 3) {
+            throw std::runtime_error("Streaming needs a 3D dataset");
+        }
+        hsize_t dims[3];
+        sp.getSimpleExtentDims(dims, nullptr);
+        n_slices_ = int(dims[0]);
+        n_angles_ = int(dims[1]);
+        n_det_ = int(dims[2]);
+
+        H5::DataType t = ds_.getDataType();
+        if (!(t == H5::PredType::NATIVE_FLOAT) && !(t == H5::PredType::NATIVE_DOUBLE)) {
+            throw std::runtime_error("Unsupported data type");
+        }
+    }
+
+    slab_slices_ = std::min(slab_slices_, std::max(n_slices_, 1));
+    slabs_.resize(std::max(depth, 2));
+    for (SinoSlab& slab : slabs_) {
+        slab.data.resize(size_t(slab_slices_) * n_angles_ * n_det_);
+        free_.push(&slab);
+    }
+
+    thread_ = std::thread(&SlabReader::run, this);
+}
+
+SlabReader::~SlabReader() {
+    // 消费者提前退出时也要让 I/O 线程从阻塞中返回
+    free_.close();
+    ready_.close();
+    if (thread_.joinable()) thread_.join();
+
+    std::lock_guard<std::mutex> lock(hdf5_mutex());
+    ds_.close();
+}
+
+void SlabReader::run() {
+    try {
+        for (int s0 = 0; s0 < n_slices_; s0 += slab_slices_) {
+            SinoSlab* slab = nullptr;
+            if (!free_.pop(slab)) return;
+
+            slab->first = s0;
+            slab->count = std::min(slab_slices_, n_slices_ - s0);
+
+            {
+                std::lock_guard<std::mutex> lock(hdf5_mutex());
+                auto t0 = std::chrono::steady_clock::now();
+                ProfileScope timer(Stage::Read);
+                H5::DataSpace file_space = ds_.getSpace();
+                hsize_t offset[3] = {hsize_t(s0), 0, 0};
+                hsize_t count[3] = {hsize_t(slab->count), hsize_t(n_angles_), hsize_t(n_det_)};
+                file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+                H5::DataSpace mem_space(3, count);
+
+                // 内存类型指定为 float，double 数据由 HDF5 分块转换，不再整卷拷贝一份 double
+                ds_.read(slab->data.data(), H5::PredType::NATIVE_FLOAT, mem_space, file_space);
+                read_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            }
+
+            if (!ready_.push(slab)) return;
+        }
+    } catch (const H5::Exception& e) {
+        // H5::Exception 不是 std::exception，转换后主线程才能统一处理
+        error_ = std::make_exception_ptr(std::runtime_error("HDF5 read failed: " + e.getDetailMsg()));
+    } catch (...) {
+        error_ = std::current_exception();
+    }
+    ready_.close();
+}
+
+SinoSlab* SlabReader::next() {
+    SinoSlab* slab = nullptr;
+    if (ready_.pop(slab)) return slab;
+    if (error_) std::rethrow_exception(error_);
+    return nullptr;
+}
+
+void SlabReader::release(SinoSlab* slab) {
+    free_.push(slab);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <H5Cpp.h>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+
+/**
+ * A run of consecutive sinogram slices, [first, first + count)
+ */
+struct SinoSlab {
+    int first = 0;
+    int count = 0;
+    std::vector<float> data;  // [count, n_angles, n_det]
+};
+
+/**
+ * Streams a [n_slices, n_angles, n_det] dataset slab by slab
+ *
+ * An I/O thread reads hyperslabs of slab_slices slices into a ring of
+ * `depth` preallocated buffers and hands them to the consumer in order, so
+ * reading the next slabs overlaps with processing the current one. Double
+ * datasets are converted to float by HDF5 while reading; no full-size
+ * staging copy is made. Peak memory is depth * slab_slices slices.
+ *
+ * HDF5 calls hold hdf5_mutex(), so a concurrent VolumeWriter is safe.
+ */
+class SlabReader {
+public:
+    /**
+     * @param ds           3D float or double dataset
+     * @param slab_slices  Slices per slab, >= 1
+     * @param depth        Number of slab buffers in the ring, >= 2
+     * @throws std::runtime_error on unsupported element type or rank
+     */
+    SlabReader(const H5::DataSet& ds, int slab_slices, int depth);
+    ~SlabReader();
+
+    SlabReader(const SlabReader&) = delete;
+    SlabReader& operator=(const SlabReader&) = delete;
+
+    /**
+     * Wait for the next slab
+     *
+     * @return nullptr after the last slab
+     * @throws the I/O thread's exception if a read failed
+     */
+    SinoSlab* next();
+
+    /** Give a slab buffer back to the I/O thread for reuse */
+    void release(SinoSlab* slab);
+
+    /** Seconds the I/O thread spent inside HDF5 reads, valid once next() returned nullptr */
+    double read_seconds() const { return read_seconds_; }
+
+private:
+    void run();
+
+    H5::DataSet ds_;
+    int n_slices_ = 0;
+    int n_angles_ = 0;
+    int n_det_ = 0;
+    int slab_slices_ = 0;
+
+    std::vector<SinoSlab> slabs_;
+    BoundedQueue<SinoSlab*> free_;
+    BoundedQueue<SinoSlab*> ready_;
+    std::exception_ptr error_;
+    double read_seconds_ = 0;
+    std::thread thread_;
+};
@@ -0,0 +1,215 @@
+#pragma GCC optimize("Ofast,fast-math,inline-functions,unroll-loops")
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include "hdf5_lock.h"
+#include "profiler.h"
+#include "volume_writer.h"
+
+namespace fs = std::filesystem;
+
+OutputFormat parse_output_format(const std::string& name) {
+    if (name == "png") return OutputFormat::PNG;
+    if (name == "raw") return OutputFormat::Raw;
+    if (name == "hdf5" || name == "h5") return OutputFormat::HDF5;
+    throw std::invalid_argument("Unknown output format: " + name + " (expected png, raw, hdf5)");
+}
+
+const char* output_format_name(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::PNG: return "png";
+        case OutputFormat::Raw: return "raw";
+        case OutputFormat::HDF5: return "hdf5";
+    }
+    return "unknown";
+}
+
+template <typename T>
+static void normalize_slice(const float* __restrict img, int h, int w, T* __restrict out, float max_value) {
+    const size_t total = size_t(h) * w;
+    float mn = img[0], mx = img[0];
+    #pragma omp simd reduction(min:mn) reduction(max:mx)
+    for (size_t i = 0; i < total; ++i) {
+        mn = std::min(mn, img[i]);
+        mx = std::max(mx, img[i]);
+    }
+    const float den = (mx > mn) ? (mx - mn) : 1.0f;
+
+    for (int y = 0; y < h; ++y) {
+        const float* __restrict src = img + size_t(y) * w;
+        T* __restrict dst = out + size_t(h - 1 - y) * w;
+        // v 在 [0, max] 内，+0.5 后截断即四舍五入，避免 std::round 阻碍向量化
+        #pragma omp simd
+        for (int x = 0; x < w; ++x) {
+            float v = (src[x] - mn) / den * max_value + 0.5f;
+            dst[x] = T(std::min(max_value, std::max(0.0f, v)));
+        }
+    }
+}
+
+void normalize_slice_u8(const float* __restrict img, int h, int w, uint8_t* __restrict out) {
+    normalize_slice(img, h, w, out, 255.0f);
+}
+
+void normalize_slice_u16(const float* __restrict img, int h, int w, uint16_t* __restrict out) {
+    normalize_slice(img, h, w, out, 65535.0f);
+}
+
+VolumeWriter::VolumeWriter(OutputFormat format, const std::string& out_dir, int n_slices, int h, int w,
+                           int threads, int queue_slices, int png_bits)
+    : format_(format), h_(h), w_(w), png_bits_(png_bits), jobs_(std::max(queue_slices, 1)) {
+    if (png_bits != 8 && png_bits != 16) throw std::invalid_argument("PNG bits must be 8 or 16");
+    fs::create_directories(out_dir);
+    switch (format_) {
+        case OutputFormat::PNG:
+            path_ = out_dir;
+            break;
+        case OutputFormat::Raw:
+            path_ = (fs::path(out_dir) / "volume.raw").string();
+            raw_ = std::fopen(path_.c_str(), "wb");
+            if (!raw_) throw std::runtime_error("Cannot open " + path_ + " for writing");
+            break;
+        case OutputFormat::HDF5: {
+            path_ = (fs::path(out_dir) / "volume.h5").string();
+            std::lock_guard<std::mutex> lock(hdf5_mutex());
+            h5_ = std::make_unique<H5::H5File>(path_, H5F_ACC_TRUNC);
+            hsize_t dims[3] = {hsize_t(n_slices), hsize_t(h), hsize_t(w)};
+            hsize_t chunk[3] = {1, hsize_t(h), hsize_t(w)};
+            H5::DSetCreatPropList props;
+            props.setChunk(3, chunk);
+            h5_ds_ = h5_->createDataSet("/recon", H5::PredType::NATIVE_FLOAT, H5::DataSpace(3, dims), props);
+            break;
+        }
+    }
+
+    for (int t = 0; t < std::max(threads, 1); ++t) {
+        workers_.emplace_back(&VolumeWriter::run, this);
+    }
+}
+
+VolumeWriter::~VolumeWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // 析构时不能再抛出，调用方应显式 finish() 获取错误
+    }
+}
+
+void VolumeWriter::rethrow_error() {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (error_) std::rethrow_exception(error_);
+}
+
+void VolumeWriter::write(int first, int count, std::vector<float>&& slab) {
+    auto shared = std::make_shared<const std::vector<float>>(std::move(slab));
+    const size_t slice_size = size_t(h_) * w_;
+    for (int i = 0; i < count; ++i) {
+        rethrow_error();
+        jobs_.push(SliceJob{shared, nullptr, i * slice_size, first + i});
+    }
+}
+
+void VolumeWriter::write_quantized(int first, int count, std::vector<uint8_t>&& slab) {
+    if (format_ != OutputFormat::PNG) throw std::logic_error("Quantized slices can only be written as PNG");
+    auto shared = std::make_shared<const std::vector<uint8_t>>(std::move(slab));
+    const size_t slice_bytes = size_t(h_) * w_ * (png_bits_ / 8);
+    for (int i = 0; i < count; ++i) {
+        rethrow_error();
+        SliceJob job;
+        job.quantized = shared;
+        job.offset = i * slice_bytes;
+        job.index = first + i;
+        jobs_.push(std::move(job));
+    }
+}
+
+void VolumeWriter::finish() {
+    if (finished_) return;
+    finished_ = true;
+    jobs_.close();
+    for (std::thread& t : workers_) t.join();
+
+    if (raw_) {
+        std::fclose(raw_);
+        raw_ = nullptr;
+    }
+    if (h5_) {
+        std::lock_guard<std::mutex> lock(hdf5_mutex());
+        h5_ds_.close();
+        h5_->close();
+        h5_.reset();
+    }
+    rethrow_error();
+}
+
+void VolumeWriter::run() {
+    std::vector<uint8_t> scratch;
+    SliceJob job;
+    while (jobs_.pop(job)) {
+        try {
+            ProfileScope timer(Stage::Write);
+            write_slice(job, scratch);
+        } catch (const H5::Exception& e) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) error_ = std::make_exception_ptr(std::runtime_error("HDF5 write failed: " + e.getDetailMsg()));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+        job.slab.reset();  // 最后一个切片写完即释放整个 slab
+        job.quantized.reset();
+    }
+}
+
+void VolumeWriter::write_png(int index, void* pixels) {
+    char filename[64];
+    snprintf(filename, sizeof(filename), "recon_%03d.png", index);
+    cv::Mat mat(h_, w_, png_bits_ == 16 ? CV_16UC1 : CV_8UC1, pixels);
+    std::string path = (fs::path(path_) / filename).string();
+    if (!cv::imwrite(path, mat)) throw std::runtime_error("Failed to write " + path);
+}
+
+void VolumeWriter::write_slice(const SliceJob& job, std::vector<uint8_t>& scratch) {
+    const size_t slice_size = size_t(h_) * w_;
+
+    if (job.quantized) {
+        // 已在反投影尾处理中量化，直接编码
+        write_png(job.index, const_cast<uint8_t*>(job.quantized->data() + job.offset));
+        return;
+    }
+    const float* img = job.slab->data() + job.offset;
+
+    switch (format_) {
+        case OutputFormat::PNG: {
+            scratch.resize(slice_size * (png_bits_ / 8));
+            if (png_bits_ == 16) {
+                normalize_slice_u16(img, h_, w_, reinterpret_cast<uint16_t*>(scratch.data()));
+            } else {
+                normalize_slice_u8(img, h_, w_, scratch.data());
+            }
+            write_png(job.index, scratch.data());
+            break;
+        }
+        case OutputFormat::Raw: {
+            std::lock_guard<std::mutex> lock(file_mutex_);
+            if (std::fseek(raw_, long(job.index * slice_size * sizeof(float)), SEEK_SET) != 0 ||
+                std::fwrite(img, sizeof(float), slice_size, raw_) != slice_size) {
+                throw std::runtime_error("Failed to write " + path_);
+            }
+            break;
+        }
+        case OutputFormat::HDF5: {
+            std::lock_guard<std::mutex> lock(hdf5_mutex());
+            H5::DataSpace file_space = h5_ds_.getSpace();
+            hsize_t offset[3] = {hsize_t(job.index), 0, 0};
+            hsize_t count[3] = {1, hsize_t(h_), hsize_t(w_)};
+            file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+            H5::DataSpace mem_space(3, count);
+            h5_ds_.write(img, H5::PredType::NATIVE_FLOAT, mem_space, file_space);
+            break;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <H5Cpp.h>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+
+enum class OutputFormat {
+    PNG,   // One 8- or 16-bit PNG per slice, min/max normalized
+    Raw,   // Single float32 file, [n_slices, h, w]
+    HDF5   // Single float32 dataset /recon, [n_slices, h, w]
+};
+
+/**
+ * @throws std::invalid_argument for unknown names
+ */
+OutputFormat parse_output_format(const std::string& name);
+const char* output_format_name(OutputFormat format);
+
+/**
+ * Min/max normalize a slice to 8 bits, flipping it vertically (row 0 of
+ * out is row h-1 of img) so it displays the usual way up
+ */
+void normalize_slice_u8(const float* img, int h, int w, uint8_t* out);
+
+/** Same as normalize_slice_u8 with 16 bits */
+void normalize_slice_u16(const float* img, int h, int w, uint16_t* out);
+
+/**
+ * Asynchronous multi-threaded writer for reconstructed slices
+ *
+ * write() hands a slab over and returns as soon as its slices fit into
+ * the bounded job queue; worker threads normalize/encode and write the
+ * slices in parallel, so output overlaps with reconstructing the next
+ * slab. The slab memory is released once its last slice is written.
+ */
+class VolumeWriter {
+public:
+    /**
+     * @param format       Output format
+     * @param out_dir      Output directory (created if missing)
+     * @param n_slices     Total number of slices in the volume
+     * @param h, w         Slice size
+     * @param threads      Worker threads, >= 1
+     * @param queue_slices Maximum slices waiting to be written
+     * @param png_bits     8 or 16 bits per PNG pixel
+     */
+    VolumeWriter(OutputFormat format, const std::string& out_dir, int n_slices, int h, int w,
+                 int threads, int queue_slices, int png_bits = 8);
+    ~VolumeWriter();
+
+    VolumeWriter(const VolumeWriter&) = delete;
+    VolumeWriter& operator=(const VolumeWriter&) = delete;
+
+    /**
+     * Queue slices [first, first + count); slab holds them contiguously
+     *
+     * @throws the first error of a worker thread
+     */
+    void write(int first, int count, std::vector<float>&& slab);
+
+    /**
+     * Queue already quantized slices (PNG only): png_bits-bit pixels in
+     * the layout normalize_slice_u8 / _u16 produce, e.g. from
+     * fbp_reconstruct_quantized_3d
+     *
+     * @param slab  count * h * w pixels of png_bits / 8 bytes each
+     * @throws std::logic_error for other formats, or a worker's first error
+     */
+    void write_quantized(int first, int count, std::vector<uint8_t>&& slab);
+
+    /**
+     * Wait until every queued slice is written and close the output
+     *
+     * @throws the first error of a worker thread
+     */
+    void finish();
+
+    /** Where the output went: a directory for PNG, otherwise the file */
+    const std::string& path() const { return path_; }
+
+private:
+    struct SliceJob {
+        std::shared_ptr<const std::vector<float>> slab;
+        std::shared_ptr<const std::vector<uint8_t>> quantized;  // Set instead of slab (offset in bytes)
+        size_t offset = 0;
+        int index = 0;
+    };
+
+    void run();
+    void write_slice(const SliceJob& job, std::vector<uint8_t>& scratch);
+    void write_png(int index, void* pixels);
+    void rethrow_error();
+
+    OutputFormat format_;
+    std::string path_;
+    int h_, w_;
+    int png_bits_;
+
+    BoundedQueue<SliceJob> jobs_;
+    std::vector<std::thread> workers_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+    bool finished_ = false;
+
+    std::mutex file_mutex_;     // Raw file position
+    std::FILE* raw_ = nullptr;
+    std::unique_ptr<H5::H5File> h5_;
+    H5::DataSet h5_ds_;
+};